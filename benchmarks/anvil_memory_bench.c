@@ -0,0 +1,339 @@
+/**
+ * @file anvil_memory_bench.c
+ * @brief Compares every allocator type against glibc `malloc` and reports the results as JSON.
+ *
+ * Built when `BUILD_BENCHMARKS` is on, against the library built with the release flags of
+ * `set_compiler_options`. Every configuration combines an allocator, a size distribution, a
+ * reset frequency and a growth scenario:
+ *
+ * - sizes: `small` allocates 32 bytes, `mixed` 8 to 512 bytes and `large` 1 KiB to 64 KiB,
+ *   with sizes drawn from a fixed seed so every allocator sees the same sequence.
+ * - reset_every: the arena is reset after this many allocations, 0 resets once per round.
+ *   `malloc` frees everything allocated since the last reset instead.
+ * - growth: `presized` arenas are created large enough for everything allocated between two
+ *   resets, `grow` arenas start at 4 KiB and grow their block chains.
+ *
+ * Each configuration runs several rounds and reports the best one. Every allocation has its
+ * first byte written so untouched memory is never measured. RSS is the growth in resident
+ * memory from before the arena was created to the end of the last round, before its final
+ * reset. SCRATCH arenas never grow, so an allocation that does not fit resets the arena and
+ * is retried; allocations that still fail are reported as failures.
+ *
+ * CONCURRENT arenas are also run shared between 1 to 8 threads, each allocating the whole
+ * size sequence from a `presized` arena, to show how claims scale with contention. Those results
+ * carry a `threads` field and report the wall time of the slowest thread per allocation made
+ * by all of them.
+ */
+
+#include "anvil/memory/arena.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_ROUNDS       ((size_t)5)
+#define BENCH_ALIGNMENT    ((size_t)16)
+#define BENCH_GROW_INITIAL ((size_t)4096)
+#define BENCH_MALLOC       COUNT
+
+typedef struct {
+	const char *name;
+	size_t min_size;
+	size_t max_size;
+	size_t operations;
+} BenchDistribution;
+
+static const BenchDistribution distributions[] = {
+    {.name = "small", .min_size = 32, .max_size = 32, .operations = (size_t)1 << 16},
+    {.name = "mixed", .min_size = 8, .max_size = 512, .operations = (size_t)1 << 16},
+    {.name = "large", .min_size = 1024, .max_size = (size_t)1 << 16, .operations = (size_t)1 << 11},
+};
+
+static const size_t reset_intervals[] = {64, 4096, 0};
+
+static const size_t thread_counts[] = {1, 2, 4, 8};
+
+typedef struct {
+	MemoryArena **arena;
+	const size_t *sizes;
+	size_t operations;
+	size_t failures;
+	pthread_barrier_t *start;
+} BenchWorker;
+
+static const AllocatorType allocators[] = {SCRATCH, LINEAR, STACK, POOL, CONCURRENT, SIZE_CLASS, VIRTUAL,
+                                           BENCH_MALLOC};
+
+static const char *bench_allocator_name(const AllocatorType type) {
+	switch (type) {
+		case SCRATCH:
+			return "SCRATCH";
+		case LINEAR:
+			return "LINEAR";
+		case STACK:
+			return "STACK";
+		case POOL:
+			return "POOL";
+		case CONCURRENT:
+			return "CONCURRENT";
+		case SIZE_CLASS:
+			return "SIZE_CLASS";
+		case VIRTUAL:
+			return "VIRTUAL";
+		case COUNT:
+		default:
+			return "malloc";
+	}
+}
+
+static inline uint64_t bench_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static size_t bench_rss(void) {
+	FILE *statm = fopen("/proc/self/statm", "r");
+	size_t pages = 0;
+	size_t resident = 0;
+
+	if (!statm) {
+		return 0;
+	}
+	if (fscanf(statm, "%zu %zu", &pages, &resident) != 2) {
+		resident = 0;
+	}
+	fclose(statm);
+	return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/*
+ * Draws sizes log-uniformly between the power of two bounds of the distribution, so small
+ * sizes are as common in the `large` distribution as they are in real workloads.
+ */
+static void bench_fill_sizes(const BenchDistribution *const distribution, size_t *const sizes) {
+	const unsigned low = (unsigned)__builtin_ctzll(distribution->min_size);
+	const unsigned high = (unsigned)__builtin_ctzll(distribution->max_size);
+	uint64_t state = 0x9E3779B97F4A7C15u;
+
+	for (size_t i = 0; i < distribution->operations; i++) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+
+		const unsigned exponent = low + (unsigned)(state % (high - low + 1));
+		const size_t size = ((size_t)1 << exponent) + (size_t)((state >> 32) % ((size_t)1 << exponent));
+		sizes[i] = size < distribution->max_size ? size : distribution->max_size;
+	}
+}
+
+/*
+ * Bytes allocated between two resets, each allocation padded to the alignment, or slots of
+ * the largest size for POOL arenas.
+ */
+static size_t bench_window_bytes(const AllocatorType type, const size_t *const sizes, const size_t operations,
+                                 const size_t reset_every, const size_t max_size) {
+	const size_t window = reset_every ? reset_every : operations;
+	size_t largest = 0;
+
+	for (size_t start = 0; start < operations; start += window) {
+		size_t bytes = 0;
+		for (size_t i = start; i < start + window && i < operations; i++) {
+			bytes += type == POOL ? max_size : (sizes[i] + (BENCH_ALIGNMENT - 1)) & ~(BENCH_ALIGNMENT - 1);
+		}
+		largest = bytes > largest ? bytes : largest;
+	}
+	return largest;
+}
+
+static void bench_release(void **const live, size_t *const count) {
+	for (size_t i = 0; i < *count; i++) {
+		free(live[i]);
+	}
+	*count = 0;
+}
+
+static void bench_run(const AllocatorType type, const BenchDistribution *const distribution,
+                      const size_t *const sizes, const size_t reset_every, const bool presized, bool *const first) {
+	const size_t operations = distribution->operations;
+	const bool arena_backed = type != BENCH_MALLOC;
+	void **live = arena_backed ? NULL : malloc(operations * sizeof(void *));
+	size_t live_count = 0;
+
+	malloc_trim(0);
+	memory_recycler_drain();
+	const size_t baseline = bench_rss();
+
+	MemoryArena *arena = NULL;
+	if (arena_backed) {
+		size_t capacity = BENCH_GROW_INITIAL;
+		if (presized) {
+			capacity = bench_window_bytes(type, sizes, operations, reset_every, distribution->max_size);
+		} else if (type == SCRATCH || type == POOL) {
+			capacity = distribution->max_size > capacity ? distribution->max_size : capacity;
+		}
+		const MemoryArenaOptions options = {.pool_slot_size = distribution->max_size};
+		arena = memory_arena_create_with_options(type, BENCH_ALIGNMENT, capacity, &options);
+	}
+
+	uint64_t best = UINT64_MAX;
+	size_t rss = 0;
+	size_t failures = 0;
+	for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+		const uint64_t start = bench_now();
+		for (size_t i = 0; i < operations; i++) {
+			char *ptr;
+			if (arena_backed) {
+				ptr = memory_arena_alloc(&arena, sizes[i]);
+				if (!ptr) {
+					memory_arena_reset(&arena);
+					ptr = memory_arena_alloc(&arena, sizes[i]);
+				}
+			} else {
+				ptr = malloc(sizes[i]);
+				live[live_count++] = ptr;
+			}
+
+			if (ptr) {
+				*(volatile char *)ptr = 1;
+			} else {
+				failures++;
+			}
+
+			if (reset_every && (i + 1) % reset_every == 0) {
+				if (arena_backed) {
+					memory_arena_reset(&arena);
+				} else {
+					bench_release(live, &live_count);
+				}
+			}
+		}
+		const uint64_t allocated = bench_now();
+
+		if (round == BENCH_ROUNDS - 1) {
+			const size_t resident = bench_rss();
+			rss = resident > baseline ? resident - baseline : 0;
+		}
+
+		const uint64_t reset = bench_now();
+		if (arena_backed) {
+			memory_arena_reset(&arena);
+		} else {
+			bench_release(live, &live_count);
+		}
+		const uint64_t elapsed = (allocated - start) + (bench_now() - reset);
+
+		best = elapsed < best ? elapsed : best;
+	}
+
+	if (arena_backed) {
+		memory_arena_destroy(&arena);
+	}
+	free(live);
+
+	const double ns_per_op = (double)best / (double)operations;
+	printf("%s    {\"allocator\": \"%s\", \"sizes\": \"%s\", \"reset_every\": %zu, \"growth\": \"%s\", "
+	       "\"operations\": %zu, \"ns_per_op\": %.3f, \"allocs_per_sec\": %.0f, \"rss_bytes\": %zu, "
+	       "\"failures\": %zu}",
+	       *first ? "" : ",\n", bench_allocator_name(type), distribution->name, reset_every,
+	       arena_backed ? (presized ? "presized" : "grow") : "none", operations, ns_per_op,
+	       ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0, rss, failures);
+	fflush(stdout);
+	*first = false;
+}
+
+static void *bench_worker(void *argument) {
+	BenchWorker *worker = argument;
+
+	pthread_barrier_wait(worker->start);
+	for (size_t i = 0; i < worker->operations; i++) {
+		char *ptr = memory_arena_alloc(worker->arena, worker->sizes[i]);
+		if (ptr) {
+			*(volatile char *)ptr = 1;
+		} else {
+			worker->failures++;
+		}
+	}
+	return NULL;
+}
+
+static void bench_run_threads(const BenchDistribution *const distribution, const size_t *const sizes,
+                              const size_t threads, bool *const first) {
+	const size_t operations = distribution->operations;
+	const size_t capacity =
+	    bench_window_bytes(CONCURRENT, sizes, operations, 0, distribution->max_size) * threads;
+	MemoryArena *arena = memory_arena_create(CONCURRENT, BENCH_ALIGNMENT, capacity);
+	pthread_t handles[8];
+	BenchWorker workers[8];
+	pthread_barrier_t start;
+
+	uint64_t best = UINT64_MAX;
+	size_t failures = 0;
+	for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+		pthread_barrier_init(&start, NULL, (unsigned)threads + 1);
+		for (size_t t = 0; t < threads; t++) {
+			workers[t] = (BenchWorker){.arena = &arena, .sizes = sizes, .operations = operations, .start = &start};
+			pthread_create(&handles[t], NULL, bench_worker, &workers[t]);
+		}
+
+		const uint64_t begin = bench_now();
+		pthread_barrier_wait(&start);
+		for (size_t t = 0; t < threads; t++) {
+			pthread_join(handles[t], NULL);
+			failures += workers[t].failures;
+		}
+		const uint64_t elapsed = bench_now() - begin;
+		pthread_barrier_destroy(&start);
+
+		memory_arena_reset(&arena);
+		best = elapsed < best ? elapsed : best;
+	}
+	memory_arena_destroy(&arena);
+
+	const double ns_per_op = (double)best / (double)(operations * threads);
+	printf("%s    {\"allocator\": \"CONCURRENT\", \"sizes\": \"%s\", \"reset_every\": 0, \"growth\": \"presized\", "
+	       "\"threads\": %zu, \"operations\": %zu, \"ns_per_op\": %.3f, \"allocs_per_sec\": %.0f, "
+	       "\"failures\": %zu}",
+	       *first ? "" : ",\n", distribution->name, threads, operations * threads, ns_per_op,
+	       ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0, failures);
+	fflush(stdout);
+	*first = false;
+}
+
+int main(void) {
+	bool first = true;
+
+	printf("{\n  \"benchmark\": \"anvil_memory_bench\",\n  \"rounds\": %zu,\n  \"alignment\": %zu,\n"
+	       "  \"results\": [\n",
+	       BENCH_ROUNDS, BENCH_ALIGNMENT);
+
+	for (size_t d = 0; d < sizeof(distributions) / sizeof(distributions[0]); d++) {
+		const BenchDistribution *const distribution = &distributions[d];
+		size_t *sizes = malloc(distribution->operations * sizeof(size_t));
+		if (!sizes) {
+			return EXIT_FAILURE;
+		}
+		bench_fill_sizes(distribution, sizes);
+
+		for (size_t r = 0; r < sizeof(reset_intervals) / sizeof(reset_intervals[0]); r++) {
+			const size_t reset_every = reset_intervals[r];
+			for (size_t a = 0; a < sizeof(allocators) / sizeof(allocators[0]); a++) {
+				bench_run(allocators[a], distribution, sizes, reset_every, true, &first);
+				if (allocators[a] != BENCH_MALLOC) {
+					bench_run(allocators[a], distribution, sizes, reset_every, false, &first);
+				}
+			}
+		}
+		for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+			bench_run_threads(distribution, sizes, thread_counts[t], &first);
+		}
+		free(sizes);
+	}
+
+	printf("\n  ]\n}\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file check_level_bench.c
+ * @brief Measures the cost of a single allocation at the check level the library was built with.
+ *
+ * Built once per check level when `BUILD_BENCHMARKS` is on. Every run reports the best of
+ * several rounds, in cycles per allocation where the time stamp counter is available and in
+ * nanoseconds otherwise. Each round allocates from an arena that was reset before the round,
+ * so no round grows its arena and only the hot path is measured.
+ *
+ * The bump allocated types are measured a second time through the inline fast path of
+ * `arena_inline.h`, reported with an `inline` suffix. Invariants are not checked on that path,
+ * so it costs the same at every level.
+ */
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/arena_inline.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+static inline uint64_t bench_now(void) {
+	return __rdtsc();
+}
+#else
+#define BENCH_UNIT "ns"
+static inline uint64_t bench_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+#endif
+
+#ifndef CHECK_LEVEL_NAME
+#define CHECK_LEVEL_NAME "DEFAULT"
+#endif
+
+#define BENCH_ALLOCATIONS ((size_t)1 << 16)
+#define BENCH_ROUNDS      ((size_t)64)
+#define BENCH_SIZE        ((size_t)32)
+#define BENCH_ALIGNMENT   ((size_t)16)
+
+/*
+ * Allocates through the inline fast path of `type`, specialized at compile time for the type and
+ * the benchmark alignment.
+ */
+#define BENCH_INLINE(type)                                                                                             \
+	static void *bench_inline_##type(MemoryArena **const arena, const size_t size) {                               \
+		return MEMORY_ARENA_ALLOC_INLINE(arena, type, BENCH_ALIGNMENT, size);                                  \
+	}
+
+BENCH_INLINE(SCRATCH)
+BENCH_INLINE(LINEAR)
+BENCH_INLINE(STACK)
+BENCH_INLINE(VIRTUAL)
+
+/*
+ * Always inlined, so the constant `alloc` of every call site is called directly and the inline
+ * fast path is inlined into the measured loop.
+ */
+static inline __attribute__((always_inline)) void bench_allocator(const AllocatorType type, const char *const name,
+                                                                  void *(*const alloc)(MemoryArena **, size_t)) {
+	const MemoryArenaOptions options = {.pool_slot_size = BENCH_SIZE};
+	MemoryArena *arena =
+	    memory_arena_create_with_options(type, BENCH_ALIGNMENT, BENCH_ALLOCATIONS * BENCH_SIZE * 2, &options);
+	uint64_t best = UINT64_MAX;
+
+	for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+		memory_arena_reset(&arena);
+
+		const uint64_t start = bench_now();
+		for (size_t i = 0; i < BENCH_ALLOCATIONS; i++) {
+			void *volatile ptr = alloc(&arena, BENCH_SIZE);
+			(void)ptr;
+		}
+		const uint64_t elapsed = bench_now() - start;
+
+		best = elapsed < best ? elapsed : best;
+	}
+
+	memory_arena_destroy(&arena);
+
+	printf("%-9s %-17s %6.2f %s/alloc\n", CHECK_LEVEL_NAME, name, (double)best / (double)BENCH_ALLOCATIONS,
+	       BENCH_UNIT);
+}
+
+int main(void) {
+	bench_allocator(SCRATCH, "SCRATCH", memory_arena_alloc);
+	bench_allocator(LINEAR, "LINEAR", memory_arena_alloc);
+	bench_allocator(STACK, "STACK", memory_arena_alloc);
+	bench_allocator(POOL, "POOL", memory_arena_alloc);
+	bench_allocator(SIZE_CLASS, "SIZE_CLASS", memory_arena_alloc);
+	bench_allocator(VIRTUAL, "VIRTUAL", memory_arena_alloc);
+	bench_allocator(SCRATCH, "SCRATCH inline", bench_inline_SCRATCH);
+	bench_allocator(LINEAR, "LINEAR inline", bench_inline_LINEAR);
+	bench_allocator(STACK, "STACK inline", bench_inline_STACK);
+	bench_allocator(VIRTUAL, "VIRTUAL inline", bench_inline_VIRTUAL);
+	return 0;
+}
@@ -43,6 +43,21 @@ function(set_compiler_options project_name)
   )
 endfunction()
 
+# Function to select the invariant check level of a target (FAST, DEFAULT or PARANOID)
+function(set_check_level project_name level)
+  if(level STREQUAL "FAST")
+    set(level_value 0)
+  elseif(level STREQUAL "DEFAULT")
+    set(level_value 1)
+  elseif(level STREQUAL "PARANOID")
+    set(level_value 2)
+  else()
+    message(FATAL_ERROR "Unknown ANVIL_MEMORY_CHECK_LEVEL '${level}', expected FAST, DEFAULT or PARANOID")
+  endif()
+
+  target_compile_definitions(${project_name} PRIVATE ANVIL_MEMORY_CHECK_LEVEL=${level_value})
+endfunction()
+
 # Function to recursively find all source files
 function(get_all_sources output_var root_dir)
     file(GLOB_RECURSE sources 
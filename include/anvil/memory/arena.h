@@ -9,18 +9,328 @@
 typedef struct memory_arena_t MemoryArena;
 
 typedef enum allocator_type_t {
-	SCRATCH = 0,    ///< Scratch allocation strategy.
-	LINEAR = 1,     ///< Linear allocation strategy.
-	STACK = 2,      ///< Stack allocation strategy.
-	POOL = 3,       ///< Pool allocation strategy.
-	COUNT           ///< Total count of allocators.
+	SCRATCH = 0,       ///< Scratch allocation strategy.
+	LINEAR = 1,        ///< Linear allocation strategy.
+	STACK = 2,         ///< Stack allocation strategy.
+	POOL = 3,          ///< Pool allocation strategy.
+	CONCURRENT = 4,    ///< Lock-free linear allocation strategy that may be shared between threads.
+	SIZE_CLASS = 5,    ///< Segregated size class allocation strategy with per-object free.
+	VIRTUAL = 6,       ///< Linear allocation from one contiguous reservation committed on demand.
+	COUNT              ///< Total count of allocators.
 } AllocatorType;
 
+/**
+ * @brief Kind of pages backing the memory of an arena.
+ *
+ * Ordered from weakest to strongest, so the backing reported for an arena is the weakest one
+ * obtained for any of its blocks.
+ */
+typedef enum memory_page_backing_t {
+	MEMORY_PAGES_DEFAULT = 0,        ///< Regular pages of the system page size.
+	MEMORY_PAGES_TRANSPARENT = 1,    ///< Regular mapping advised to use transparent huge pages.
+	MEMORY_PAGES_HUGETLB = 2,        ///< Explicit 2 MiB pages from the hugetlb pool.
+} MemoryPageBacking;
+
+/**
+ * @brief How `memory_arena_reset` clears the memory handed out before the reset.
+ */
+typedef enum memory_reset_zeroing_t {
+	MEMORY_RESET_ZERO_EAGER = 0,      ///< Zero the used memory with `memset`.
+	MEMORY_RESET_ZERO_NONE = 1,       ///< Leave the used memory as it is.
+	MEMORY_RESET_ZERO_RELEASE = 2,    ///< Return whole used pages to the kernel with `MADV_DONTNEED`.
+} MemoryResetZeroing;
+
+/**
+ * @brief Where the pages of an arena's blocks are placed on a NUMA system.
+ */
+typedef enum memory_numa_policy_t {
+	MEMORY_NUMA_DEFAULT = 0,       ///< Follow the policy of the thread that first touches a page.
+	MEMORY_NUMA_BIND = 1,          ///< Place every page on `MemoryArenaOptions.numa_node`.
+	MEMORY_NUMA_INTERLEAVE = 2,    ///< Spread pages round robin over the nodes the process may use.
+} MemoryNumaPolicy;
+
+/**
+ * @brief Number of NUMA nodes an arena can be bound to, nodes 0 to 63.
+ */
+#define MEMORY_NUMA_MAX_NODES ((size_t)64)
+
+/**
+ * @brief Number of size classes of a SIZE_CLASS arena.
+ *
+ * The classes are 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448 and
+ * 512 bytes.
+ */
+#define MEMORY_SIZE_CLASS_COUNT ((size_t)16)
+
+/**
+ * @brief Largest alignment accepted by `memory_arena_alloc_aligned`.
+ */
+#define MEMORY_ARENA_MAX_ALIGNMENT ((size_t)1 << 16)
+
+/**
+ * @brief Occupancy of a single size class of a SIZE_CLASS arena.
+ *
+ * Fields    | Type   | Description
+ * --------- | ------ | ---------------------------------------------------------------
+ * slot_size | size_t | Size of the slots of the class in bytes.
+ * runs      | size_t | Runs carved for the class since the arena was created or reset.
+ * slots     | size_t | Slots in those runs.
+ * live      | size_t | Slots currently allocated and not yet freed.
+ */
+typedef struct memory_size_class_occupancy_t {
+	size_t slot_size;    ///< Size of the slots of the class.
+	size_t runs;         ///< Runs carved for the class.
+	size_t slots;        ///< Slots in the runs of the class.
+	size_t live;         ///< Slots currently in use.
+} MemorySizeClassOccupancy;
+
+/**
+ * @brief Statistics of a single arena, reported by `memory_arena_get_stats`.
+ *
+ * Allocation counters are maintained by every successful allocation unless the library is
+ * built with `ANVIL_MEMORY_STATS` set to 0, in which case they stay zero. Block counters are
+ * always maintained.
+ *
+ * Fields          | Type   | Description
+ * --------------- | ------ | ---------------------------------------------------------------
+ * allocations     | size_t | Successful allocations since the arena was created. A batch
+ *                 |        | counts one allocation per object.
+ * bytes_requested | size_t | Bytes requested by allocations since the last reset.
+ * bytes_used      | size_t | Bytes taken from the arena's blocks, including alignment padding,
+ *                 |        | freed slots and carved runs.
+ * padding         | size_t | Bytes used but not requested. Only reported by arenas that bump
+ *                 |        | allocate; POOL and SIZE_CLASS arenas report 0.
+ * high_water      | size_t | Largest `bytes_used` seen at a reset, an unwind or a query.
+ * blocks          | size_t | Blocks currently owned by the arena.
+ * capacity        | size_t | Combined capacity of those blocks.
+ * block_maps      | size_t | Blocks created with a fresh mapping.
+ * block_reuses    | size_t | Blocks taken from the process-wide block recycler.
+ * block_releases  | size_t | Blocks released by reset, unwind or growth.
+ * block_unmaps    | size_t | Released blocks handed back with `munmap` rather than recycled.
+ * page_backing    | enum   | Weakest page backing obtained for any block the arena has used.
+ *                 |        | Always `MEMORY_PAGES_DEFAULT` without `MemoryArenaOptions.huge_pages`,
+ *                 |        | `MEMORY_PAGES_HUGETLB` means every block came from the hugetlb pool.
+ *
+ * Every block the arena owned came from a fresh mapping or the block recycler, so
+ * `block_maps + block_reuses == blocks + block_releases`. Blocks still owned when the arena
+ * is destroyed are not counted as released.
+ */
+typedef struct memory_arena_stats_t {
+	size_t allocations;                ///< Successful allocations.
+	size_t bytes_requested;            ///< Bytes requested since the last reset.
+	size_t bytes_used;                 ///< Bytes taken from the blocks of the arena.
+	size_t padding;                    ///< Bytes used but not requested.
+	size_t high_water;                 ///< Largest number of bytes used observed.
+	size_t blocks;                     ///< Blocks owned by the arena.
+	size_t capacity;                   ///< Combined capacity of the blocks.
+	size_t block_maps;                 ///< Blocks mapped for the arena.
+	size_t block_reuses;               ///< Blocks taken from the block recycler.
+	size_t block_releases;             ///< Blocks released before the arena was destroyed.
+	size_t block_unmaps;               ///< Released blocks that were unmapped.
+	MemoryPageBacking page_backing;    ///< Weakest page backing obtained for a block.
+} MemoryArenaStats;
+
+/**
+ * @brief Statistics of every live arena in the process, reported by `memory_arena_get_global_stats`.
+ *
+ * Arena counters are summed over the arenas alive at the time of the call. The mapping
+ * counters cover the whole process since it started, including arenas already destroyed and
+ * blocks parked in the block recycler.
+ *
+ * Fields          | Type   | Description
+ * --------------- | ------ | ---------------------------------------------------------------
+ * arenas          | size_t | Live arenas.
+ * allocations     | size_t | Sum of `MemoryArenaStats.allocations`.
+ * bytes_requested | size_t | Sum of `MemoryArenaStats.bytes_requested`.
+ * blocks          | size_t | Sum of `MemoryArenaStats.blocks`.
+ * capacity        | size_t | Sum of `MemoryArenaStats.capacity`.
+ * block_maps      | size_t | Sum of `MemoryArenaStats.block_maps`.
+ * block_reuses    | size_t | Sum of `MemoryArenaStats.block_reuses`.
+ * block_releases  | size_t | Sum of `MemoryArenaStats.block_releases`.
+ * block_unmaps    | size_t | Sum of `MemoryArenaStats.block_unmaps`.
+ * mmap_calls      | size_t | `mmap` calls made by the library.
+ * munmap_calls    | size_t | Mappings the library handed back with `munmap`.
+ */
+typedef struct memory_global_stats_t {
+	size_t arenas;             ///< Live arenas.
+	size_t allocations;        ///< Successful allocations of the live arenas.
+	size_t bytes_requested;    ///< Bytes requested from the live arenas since their last reset.
+	size_t blocks;             ///< Blocks owned by the live arenas.
+	size_t capacity;           ///< Combined capacity of those blocks.
+	size_t block_maps;         ///< Blocks mapped for the live arenas.
+	size_t block_reuses;       ///< Blocks the live arenas took from the block recycler.
+	size_t block_releases;     ///< Blocks the live arenas released.
+	size_t block_unmaps;       ///< Blocks the live arenas unmapped.
+	size_t mmap_calls;         ///< Mappings created by the process.
+	size_t munmap_calls;       ///< Mappings released by the process.
+} MemoryGlobalStats;
+
+/**
+ * @brief Position in a STACK arena, taken by `memory_stack_arena_mark`.
+ *
+ * A mark is a plain value the caller keeps wherever it likes, typically in a local variable
+ * of the scope it belongs to, so taking one needs no heap memory. Its fields are private to
+ * the library and must not be read or modified.
+ *
+ * Fields    | Type   | Description
+ * --------- | ------ | ---------------------------------------------------------------
+ * block     | void * | Top block of the arena when the mark was taken.
+ * allocated | size_t | Bytes allocated from that block.
+ * requested | size_t | Bytes requested from the arena since the last reset.
+ * snapshots | size_t | Snapshots recorded with `memory_stack_arena_record` at the time.
+ */
+typedef struct memory_stack_mark_t {
+	void *block;         ///< Private.
+	size_t allocated;    ///< Private.
+	size_t requested;    ///< Private.
+	size_t snapshots;    ///< Private.
+} MemoryStackMark;
+
+/**
+ * @brief Position in a bump allocated arena, taken by `memory_arena_checkpoint`.
+ *
+ * Like a stack mark, a checkpoint is a plain value kept by the caller. Its fields are private
+ * to the library and must not be read or modified.
+ *
+ * Fields    | Type   | Description
+ * --------- | ------ | ---------------------------------------------------------------
+ * position  | size_t | Capacity of the blocks before the active one plus its offset.
+ * large     | void * | Most recent large block of the arena when it was taken.
+ * snapshots | size_t | STACK only. Snapshots recorded with `memory_stack_arena_record`.
+ */
+typedef struct memory_arena_checkpoint_t {
+	size_t position;     ///< Private.
+	void *large;         ///< Private.
+	size_t snapshots;    ///< Private.
+} MemoryArenaCheckpoint;
+
+/**
+ * @brief Optional creation parameters for `memory_arena_create_with_options`.
+ *
+ * A zero-initialized options struct produces an arena that behaves exactly like one created
+ * with `memory_arena_create`, so callers only need to set the fields they care about.
+ *
+ * Block retention controls what `memory_arena_reset` does with the blocks an arena grew beyond
+ * its first one. Retained blocks stay mapped and linked to the arena with their allocation
+ * counter rewound, so an arena that repeatedly grows to the same size reaches a steady state
+ * with no `mmap`/`munmap` calls on reset. Blocks are retained in chain order until either
+ * limit is reached; the rest are released.
+ *
+ * Fields        | Type   | Description
+ * ------------- | ------ | ---------------------------------------------------------------
+ * retain_blocks | size_t | Blocks beyond the first kept across reset. `SIZE_MAX` for no limit.
+ * retain_bytes  | size_t | If non-zero, caps the combined capacity of the retained blocks.
+ * retain_decay  | size_t | If non-zero, resets the last retained block may go unused before
+ *               |        | it is released. Lets an arena shrink back after a burst.
+ * pool_slot_size| size_t | POOL only. Size of every slot, rounded up to the alignment. 0 uses
+ *               |        | the arena capacity, as `memory_arena_create` does.
+ * best_fit      | bool   | LINEAR only. When the active block is full, place the allocation in
+ *               |        | the earlier block with the tightest fit before growing.
+ * reset_zeroing | enum   | How reset clears used memory. Eager zeroing writes every used byte.
+ *               |        | Release hands whole pages of large used ranges back to the kernel,
+ *               |        | which supplies zero pages on the next touch. None skips zeroing, so
+ *               |        | memory allocated after a reset, or a POOL slot allocated again after
+ *               |        | a free, may hold data from before it.
+ * reset_release | size_t | Smallest used range of a block released rather than zeroed in
+ * _threshold    |        | release mode, 0 for 1 MiB. Smaller ranges are zeroed eagerly.
+ * virtual_      | size_t | VIRTUAL only. Address space reserved for the arena, 0 for 64 GiB
+ * reserve       |        | (1 GiB on 32-bit systems), the capacity limit if smaller, or the
+ *               |        | capacity if larger.
+ * growth_factor | size_t | Multiplier applied to the capacity of the last block when the arena
+ *               |        | grows, 0 for 2. 1 keeps every block the size of the first.
+ * growth_chunk  | size_t | If non-zero, every new block has this capacity and the growth
+ *               |        | factor is ignored.
+ * max_block_    | size_t | If non-zero, caps the capacity of new blocks. An allocation larger
+ * size          |        | than the cap still gets a block that fits it.
+ * capacity_     | size_t | If non-zero, the combined capacity of the arena's blocks never
+ * limit         |        | exceeds it. Allocations that would need more return `NULL`.
+ * large_        | size_t | LINEAR and POOL only. If non-zero, an allocation larger than this
+ * threshold     |        | that does not fit the active block gets a mapping of its own.
+ * numa_policy   | enum   | Where block pages are placed. Bind keeps them on `numa_node`,
+ *               |        | interleave spreads them over every node the process may use.
+ * numa_node     | size_t | Node the blocks are bound to with `MEMORY_NUMA_BIND`.
+ * sensitive     | bool   | The arena holds sensitive data. Used memory is wiped with
+ *               |        | `explicit_bzero` before a block is recycled or unmapped, and reset
+ *               |        | always zeroes eagerly. Other arenas unmap blocks without wiping them.
+ * huge_pages    | bool   | Back blocks with 2 MiB pages. Explicit `MAP_HUGETLB` pages are tried
+ *               |        | first, falling back to a 2 MiB aligned mapping advised with
+ *               |        | `MADV_HUGEPAGE`. Block capacities are rounded up to fill whole huge
+ *               |        | pages. `MemoryArenaStats.page_backing` reports what was obtained.
+ * prefault      | bool   | Fault in every page of a block when it is created, so allocations
+ *               |        | never take a first-touch page fault. Costs the whole block up front.
+ * spare_block   | bool   | Growing arenas only. Keep one prefaulted block ready, prepared by
+ *               |        | a background thread, to be taken when the arena next grows.
+ *
+ * Arenas other than SCRATCH and VIRTUAL grow by appending a block when their last block is
+ * full. By default each block doubles the capacity of the one before it, so a long running
+ * arena asks for ever larger mappings. The growth fields bound that: a fixed chunk or a
+ * smaller factor keeps blocks small, `max_block_size` caps them and `capacity_limit` makes
+ * allocation fail instead of mapping more memory. The limit is checked against the capacity
+ * a block is mapped with, after huge page rounding. The first block counts against it too,
+ * after SIZE_CLASS arenas round it up to a 64 KiB run, and a limit it does not fit is a
+ * programmer error.
+ *
+ * Large allocations in LINEAR and POOL arenas are kept off the block chain when
+ * `large_threshold` is set. Each gets an exactly sized block on a side list of the arena,
+ * released by reset and destroy, so one oversized request neither maps a chain of ever larger
+ * blocks nor sets the size the chain grows from afterwards.
+ *
+ * LINEAR arenas allocate from an active block and only move on when it is full, which keeps
+ * allocation cost independent of the number of blocks. The space left at the end of full blocks
+ * is only reused in best-fit mode, which trades a walk over the chain on every overflow for a
+ * smaller footprint.
+ *
+ * NUMA placement is applied with `mbind` to every block as it is mapped or taken from the
+ * block recycler, moving pages that are already resident. A recycled block placed for another
+ * arena is returned to the default placement when an arena without a policy takes it. It needs
+ * no library beyond the C library. On kernels without NUMA support blocks are placed as if no
+ * policy was set.
+ *
+ * Prefaulting moves the `mmap` page faults of a block from its first allocations to its
+ * creation. Pages are populated with `MADV_POPULATE_WRITE` after NUMA placement, so they land
+ * on the right node, or written once each on kernels older than 5.14. A spare block goes
+ * further for latency-critical arenas: a refill thread shared by the process maps, places and
+ * prefaults the block the arena will grow into next, so growth only swaps a pointer as long
+ * as the spare is large enough and ready in time. Otherwise the arena maps a block as usual.
+ * The spare holds memory outside the arena's statistics and capacity limit until it is taken.
+ *
+ * VIRTUAL arenas reserve `virtual_reserve` bytes of address space up front without committing
+ * memory to it, and commit pages as allocations advance through the range. Their memory is
+ * contiguous and never moves, so a single allocation may be as large as the reservation.
+ * Allocations that no longer fit in the reservation return `NULL`. The capacity given at
+ * creation is committed immediately. The whole reservation counts against `capacity_limit`,
+ * so with a limit the default reservation shrinks to it and a larger `virtual_reserve` is a
+ * programmer error. With `huge_pages` the reservation is only advised with
+ * `MADV_HUGEPAGE`, explicit hugetlb pages are never used.
+ */
+typedef struct memory_arena_options_t {
+	size_t retain_blocks;                ///< Maximum number of blocks beyond the first kept across reset.
+	size_t retain_bytes;                 ///< Byte budget for retained blocks, 0 for no budget.
+	size_t retain_decay;                 ///< Idle resets before the last retained block is released, 0 for never.
+	size_t pool_slot_size;               ///< Slot size of POOL arenas, 0 for the arena capacity.
+	size_t reset_release_threshold;      ///< Smallest range released by reset, 0 for the default.
+	size_t virtual_reserve;              ///< Address space reserved by VIRTUAL arenas, 0 for the default.
+	size_t growth_factor;                ///< Capacity multiplier for new blocks, 0 for 2.
+	size_t growth_chunk;                 ///< Fixed capacity of new blocks, 0 to grow geometrically.
+	size_t max_block_size;               ///< Largest capacity of a new block, 0 for no limit.
+	size_t capacity_limit;               ///< Largest combined capacity of all blocks, 0 for no limit.
+	size_t large_threshold;              ///< Larger allocations get a block of their own, 0 to disable.
+	size_t numa_node;                    ///< Node blocks are bound to by `MEMORY_NUMA_BIND`.
+	MemoryResetZeroing reset_zeroing;    ///< How reset clears used memory.
+	MemoryNumaPolicy numa_policy;        ///< NUMA placement of the pages of every block.
+	bool best_fit;                       ///< Reuse space in earlier blocks before growing (LINEAR only).
+	bool huge_pages;                     ///< Back blocks with 2 MiB pages where the system allows it.
+	bool sensitive;                      ///< Wipe used memory before it is released.
+	bool prefault;                       ///< Fault in the pages of every block when it is created.
+	bool spare_block;                    ///< Keep a prefaulted block ready for growth.
+} MemoryArenaOptions;
+
 /**
  * @brief Creates a memory arena with the specified capacity and alignment
  *
  * This function allocates and initializes a new memory arena. The arena uses the specified
  * allocation strategy and ensures all allocations are aligned to the given boundary.
+ * Individual allocations can ask for a stricter alignment with `memory_arena_alloc_aligned`.
  *
  * The function will CRASH (not return an error) if any of these invariants are violated:
  * - alignment must be a power of two
@@ -31,7 +341,8 @@ typedef enum allocator_type_t {
  * The function returns the memory arena on success otherwise it returns `NULL`.
  *
  * @param[in] allocator_type 	Allocation strategy (LINEAR, etc). Must not be COUNT.
- * @param[in] alignment      	Memory alignment in bytes. Must be a power of 2.
+ * @param[in] alignment      	Memory alignment in bytes. Must be a power of 2. May be smaller
+ *                           	than the alignment of `max_align_t` to pack small objects.
  * @param[in] capacity       	Initial arena size in bytes. Must be > 0.
  *
  * @return arena 		Pointer to receive the created arena
@@ -40,10 +351,39 @@ typedef enum allocator_type_t {
  *       crashes with diagnostics rather than returning error codes
  *
  * @note The memory arenas created from this function are **NOT** thread safe and should not be used
- * in a cocurrent environment.
+ * in a cocurrent environment. The one exception is `memory_arena_alloc` on a CONCURRENT arena, which
+ * may be called from any number of threads at once. Resetting or destroying a CONCURRENT arena
+ * still requires that no other thread is allocating from it.
  */
 MemoryArena *memory_arena_create(const AllocatorType allocator_type, const size_t alignment, size_t capacity);
 
+/**
+ * @brief Creates a memory arena with the specified capacity, alignment and options.
+ *
+ * This function behaves like `memory_arena_create` but additionally applies the given
+ * creation options. Passing `NULL` for `options` is equivalent to passing a zero-initialized
+ * `MemoryArenaOptions` and therefore to calling `memory_arena_create`.
+ *
+ * The function will CRASH (not return an error) under the same conditions as
+ * `memory_arena_create`, or if the options are inconsistent:
+ * - `capacity_limit` is non-zero and smaller than the first block, which is `capacity` rounded
+ *   up as described above, or the reservation of a VIRTUAL arena.
+ * - `reset_zeroing` or `numa_policy` is not a valid value.
+ * - `numa_policy` is `MEMORY_NUMA_BIND` and `numa_node` is not a node the process may use.
+ *
+ * @param[in] allocator_type 	Allocation strategy (LINEAR, etc). Must not be COUNT.
+ * @param[in] alignment      	Memory alignment in bytes. Must be a power of 2.
+ * @param[in] capacity       	Initial arena size in bytes. Must be > 0.
+ * @param[in] options        	Creation options, may be `NULL`.
+ *
+ * @return arena 		Pointer to receive the created arena
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate
+ *       crashes with diagnostics rather than returning error codes
+ */
+MemoryArena *memory_arena_create_with_options(const AllocatorType allocator_type, const size_t alignment,
+                                              size_t capacity, const MemoryArenaOptions *const options);
+
 /**
  * @brief Destroys a memory arena and free all memory allocated to it.
  *
@@ -71,6 +411,9 @@ void memory_arena_destroy(MemoryArena **const arena);
  * from the arena before reseting the arena should be considered tainted and set to
  * NULL to avoid reading garbage values.
  *
+ * The first block of the arena is always kept. Further blocks are kept or released according
+ * to the retention options the arena was created with.
+ *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - arena is `NULL`.
  * - arena memory block is null.
@@ -94,6 +437,10 @@ void memory_arena_reset(MemoryArena **const arena);
  * - arena's memory block is null.
  * - result pointer is `NULL`.
  *
+ * Only the PARANOID check level checks the memory block, and the FAST check level skips the
+ * check on the arena as well. The check level is chosen with the `ANVIL_MEMORY_CHECK_LEVEL`
+ * build option.
+ *
  * @param[out] arena	Pointer to the arena to reset.
  * @param[in]  size	amount of memory to allocate.
  *
@@ -101,9 +448,151 @@ void memory_arena_reset(MemoryArena **const arena);
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
- * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context, unless
+ *       the arena was created with the CONCURRENT allocator type.
  */
 void *__attribute__((malloc, warn_unused_result)) memory_arena_alloc(MemoryArena **const arena, const size_t size);
+
+/**
+ * @brief Allocates `size` bytes aligned to `alignment` from a memory arena.
+ *
+ * The arena alignment only sets the alignment of plain allocations, so an arena can be
+ * created with a small alignment to pack small objects tightly while the occasional cache
+ * line or page aligned buffer is allocated from the same arena with this function. The
+ * memory is aligned to the larger of `alignment` and the arena alignment, and the bytes
+ * skipped to reach it are not reused.
+ *
+ * SIZE_CLASS arenas serve allocations with an alignment stricter than the arena alignment as
+ * large allocations, which `memory_arena_free` accepts but only reclaims on reset. POOL
+ * arenas can not align slots beyond the arena alignment and return `NULL` for such requests.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - alignment is not a power of two or larger than `MEMORY_ARENA_MAX_ALIGNMENT`.
+ * - size is zero.
+ *
+ * The FAST check level skips these checks.
+ *
+ * @param[in,out] arena Pointer to the arena to allocate from.
+ * @param[in] size Amount of memory to allocate.
+ * @param[in] alignment Alignment of the allocation in bytes.
+ *
+ * @returns pointer to the allocated memory, or `NULL` under the same conditions as
+ *          `memory_arena_alloc`.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context, unless
+ *       the arena was created with the CONCURRENT allocator type.
+ */
+void *__attribute__((malloc, warn_unused_result)) memory_arena_alloc_aligned(MemoryArena **const arena,
+                                                                             const size_t size,
+                                                                             const size_t alignment);
+
+/**
+ * @brief Allocates `count` objects of the given sizes from a memory arena in one go.
+ *
+ * Every object is padded to the arena's alignment and the objects are laid out back to back,
+ * so the whole batch is a single allocation of their summed size: the arena is dispatched on,
+ * checked for capacity and grown at most once. The objects of POOL and SIZE_CLASS arenas are
+ * allocated one at a time instead, so each of them can be returned with `memory_arena_free`.
+ *
+ * The batch is all or nothing. If it can not be allocated, every entry of `out` is set to
+ * `NULL` and nothing is allocated. The one exception are SIZE_CLASS objects above the largest
+ * size class: freeing them is a no-op, so the ones a failed batch allocated stay in use until
+ * `memory_arena_reset`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - sizes or out is `NULL` while count is not zero.
+ * - any of the sizes is zero.
+ * - the padded sizes add up to more than `SIZE_MAX`.
+ *
+ * The FAST check level only keeps the check on the summed sizes.
+ *
+ * @param[in,out] arena Pointer to the arena to allocate from.
+ * @param[in] sizes Size of each object.
+ * @param[in] count Number of objects.
+ * @param[out] out Receives a pointer to each object, in the order of `sizes`.
+ *
+ * @return true if every object was allocated, false otherwise.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context, unless
+ *       the arena was created with the CONCURRENT allocator type.
+ */
+bool __attribute__((warn_unused_result)) memory_arena_alloc_batch(MemoryArena **const arena,
+                                                                  const size_t *const sizes, const size_t count,
+                                                                  void **const out);
+
+/**
+ * @brief Allocates `count` objects of `size` bytes from a memory arena in one go.
+ *
+ * Behaves like `memory_arena_alloc_batch` with every size equal to `size`. The objects of bump
+ * allocated arenas are spaced `size` rounded up to the arena alignment apart.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - out is `NULL` while count is not zero.
+ * - size is zero.
+ * - the padded sizes add up to more than `SIZE_MAX`.
+ *
+ * The FAST check level only keeps the check on the summed sizes.
+ *
+ * @param[in,out] arena Pointer to the arena to allocate from.
+ * @param[in] size Size of every object.
+ * @param[in] count Number of objects.
+ * @param[out] out Receives a pointer to each object.
+ *
+ * @return true if every object was allocated, false otherwise.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context, unless
+ *       the arena was created with the CONCURRENT allocator type.
+ */
+bool __attribute__((warn_unused_result)) memory_arena_alloc_batch_uniform(MemoryArena **const arena,
+                                                                          const size_t size, const size_t count,
+                                                                          void **const out);
+
+/**
+ * @brief Returns a single allocation to a POOL or SIZE_CLASS arena.
+ *
+ * The memory is zero-filled and pushed onto a free list, from which the next allocation of
+ * the same size is served. Both allocation and free are O(1) in the number of allocations;
+ * the zero-fill writes the whole slot. POOL arenas created with `MEMORY_RESET_ZERO_NONE`
+ * skip it and only write the free list link, so a slot allocated again may hold data from
+ * before it was freed. Memory of other allocator types
+ * is only released in bulk by `memory_arena_reset` and `memory_arena_destroy`.
+ *
+ * A POOL arena hands out fixed-size slots. The slot size is the capacity given to
+ * `memory_arena_create`, or `MemoryArenaOptions.pool_slot_size` if set, rounded up to the
+ * arena alignment and to at least the size of a pointer. Allocations larger than a slot
+ * return `NULL`.
+ *
+ * A SIZE_CLASS arena serves allocations of up to 512 bytes from the smallest of its
+ * `MEMORY_SIZE_CLASS_COUNT` size classes that fits. Larger allocations are bump allocated and
+ * freeing them is a no-op; their memory is reclaimed by `memory_arena_reset`. The alignment of
+ * a SIZE_CLASS arena must be smaller than 64 KiB.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - arena is not a POOL or SIZE_CLASS allocator type.
+ * - ptr is `NULL` or not aligned to the arena alignment.
+ *
+ * The FAST check level only keeps the check on the allocator type.
+ *
+ * @param[in,out] arena Pointer to the arena the memory was allocated from.
+ * @param[in] ptr Allocation to return. Must not be used after this call.
+ *
+ * @note Freeing memory that did not come from this arena, or freeing it twice, is undefined behaviour.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ */
+void memory_arena_free(MemoryArena **const arena, void *const ptr);
+
 /**
  * @brief Evaluates if a memory arena has enough memory for an allocation
  *
@@ -123,6 +612,66 @@ void *__attribute__((malloc, warn_unused_result)) memory_arena_alloc(MemoryArena
  */
 bool __attribute__((pure)) memory_arena_alloc_verify(MemoryArena *const arena, const size_t size);
 
+/**
+ * @brief Reports the occupancy of every size class of a SIZE_CLASS arena.
+ *
+ * Writes one entry per size class, smallest class first, until either every class has been
+ * reported or `count` entries have been written.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL`.
+ * - arena is not a SIZE_CLASS allocator type.
+ * - occupancy is `NULL` while count is not zero.
+ *
+ * @param[in] arena Size class arena to inspect.
+ * @param[out] occupancy Array receiving the occupancy of each class.
+ * @param[in] count Number of entries `occupancy` can hold.
+ *
+ * @return Number of entries written, at most `MEMORY_SIZE_CLASS_COUNT`.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+size_t memory_arena_size_class_occupancy(MemoryArena *const arena, MemorySizeClassOccupancy *const occupancy,
+                                         const size_t count);
+
+/**
+ * @brief Reports the statistics of an arena.
+ *
+ * Walks the blocks of the arena to measure the bytes used, so the cost grows with the number
+ * of blocks. For CONCURRENT arenas the call may run concurrently with allocations and reports
+ * a snapshot that is not necessarily consistent across fields.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL`.
+ * - stats is `NULL`.
+ *
+ * @param[in,out] arena Arena to inspect. Its high water mark is updated.
+ * @param[out] stats Receives the statistics of the arena.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void memory_arena_get_stats(MemoryArena *const arena, MemoryArenaStats *const stats);
+
+/**
+ * @brief Reports statistics summed over every live arena in the process.
+ *
+ * Every arena is registered in a process-wide list when it is created and removed when it is
+ * destroyed. The call holds the lock of that list while it sums the counters of each arena,
+ * so it never reads an arena that is being destroyed, but counters of arenas used by other
+ * threads may be read in the middle of an allocation.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - stats is `NULL`.
+ *
+ * @param[out] stats Receives the statistics of the process.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void memory_arena_get_global_stats(MemoryGlobalStats *const stats);
+
 /**
  * @brief Records the current state of a stack memory arena.
  *
@@ -148,8 +697,12 @@ void memory_stack_arena_record(MemoryArena **const arena);
  * @brief Unwinds a stack memory arena to its previously recorded state.
  *
  * This function restores a stack memory arena to the most recently recorded snapshot state.
- * It resets the memory allocated after the snapshot was taken and frees any additional
- * memory blocks that were allocated. The snapshot is then removed from the snapshot stack.
+ * It resets the memory allocated after the snapshot was taken and releases the memory blocks
+ * that were added since, except for a small cache of them kept for the next time the stack
+ * grows past its top block. A loop that records, allocates across a block boundary and unwinds
+ * therefore maps no new block after its first iteration. Cached blocks are cleared as a reset
+ * clears memory and released once several unwinds in a row found them unused. The snapshot is
+ * then removed from the snapshot stack.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - arena is `NULL` or points to `NULL`.
@@ -167,6 +720,120 @@ void memory_stack_arena_record(MemoryArena **const arena);
  */
 void memory_stack_arena_unwind(MemoryArena **const arena);
 
+/**
+ * @brief Marks the current position of a stack memory arena.
+ *
+ * The mark is returned by value and costs four words wherever the caller stores it. Any number
+ * of marks can be live at once, nested like the scopes they belong to, and marks can be mixed
+ * with `memory_stack_arena_record`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL`.
+ * - arena is not a stack allocator type.
+ *
+ * The FAST check level only keeps the check on the allocator type.
+ *
+ * @param[in] arena Stack arena whose position is marked.
+ *
+ * @return A mark `memory_stack_arena_restore` can return the arena to.
+ *
+ * @note This function is only valid for arenas created with the STACK allocator type.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ */
+MemoryStackMark memory_stack_arena_mark(MemoryArena *const arena);
+
+/**
+ * @brief Returns a stack memory arena to an earlier mark.
+ *
+ * Everything allocated since the mark was taken is released in one pass, however many marks
+ * or snapshots were taken in between, so a parser can unwind any number of nested scopes at
+ * once. Blocks added since the mark are cached or released as `memory_stack_arena_unwind`
+ * does, and snapshots recorded after the mark are discarded. Marks taken after this one, and
+ * marks taken before a reset, are invalid afterwards.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - arena is not a stack allocator type.
+ * - mark was not taken from this arena, or is later than its current position. The position
+ *   is only checked completely by builds with the PARANOID check level.
+ *
+ * The FAST check level only keeps the check on the allocator type.
+ *
+ * @param[in,out] arena Pointer to the stack arena to restore.
+ * @param[in] mark Mark taken from the arena by `memory_stack_arena_mark`.
+ *
+ * @note This function is only valid for arenas created with the STACK allocator type.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ * @note All memory allocated after the mark was taken is invalidated.
+ */
+void memory_stack_arena_restore(MemoryArena **const arena, const MemoryStackMark mark);
+
+/**
+ * @brief Takes a checkpoint of a bump allocated memory arena.
+ *
+ * Checkpoints give any SCRATCH, LINEAR, STACK, CONCURRENT or VIRTUAL arena the temporary
+ * scope a stack mark gives a STACK arena, so short lived memory can come from a long lived
+ * arena instead of a second arena created for it. The checkpoint is three words, found by
+ * walking the blocks before the active one. Like a reset, taking a checkpoint of a CONCURRENT
+ * arena requires that no other thread is allocating from it.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL`.
+ * - arena is not a SCRATCH, LINEAR, STACK, CONCURRENT or VIRTUAL arena.
+ *
+ * The FAST check level only keeps the check on the allocator type.
+ *
+ * @param[in] arena Arena whose position is taken.
+ *
+ * @return A checkpoint `memory_arena_rollback` can return the arena to.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ */
+MemoryArenaCheckpoint memory_arena_checkpoint(MemoryArena *const arena);
+
+/**
+ * @brief Rolls a bump allocated memory arena back to an earlier checkpoint.
+ *
+ * Everything allocated from the arena's blocks since the checkpoint is released in one pass.
+ * The block that was active becomes active again, rewound to its offset at the time, and the
+ * blocks the arena moved on to since are emptied but kept for the allocations that follow,
+ * as a STACK arena caches them on unwind. Large blocks mapped since the checkpoint are
+ * released. Released memory is cleared as a reset clears it.
+ *
+ * Snapshots a STACK arena recorded since the checkpoint are dropped with the allocations.
+ * Allocations a best-fit LINEAR arena placed in the tail of a block before the active one are
+ * not rolled back, they stay allocated until the next reset. Best fit never reaches past the
+ * active block and `memory_arena_realloc` never resizes an allocation made before the
+ * checkpoint in place, so allocations made before the checkpoint are never rolled back
+ * either. Rolling back a CONCURRENT arena requires that no other thread is allocating from
+ * it. Statistics are not rewound.
+ * Checkpoints, marks and snapshots taken after this checkpoint, and checkpoints taken before
+ * a reset, are invalid afterwards.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - arena is not a SCRATCH, LINEAR, STACK, CONCURRENT or VIRTUAL arena.
+ * - checkpoint was not taken from this arena, or is later than its current position.
+ * - checkpoint holds more snapshots than a STACK arena has recorded.
+ *
+ * The FAST check level skips the check on the arena.
+ *
+ * @param[in,out] arena Pointer to the arena to roll back.
+ * @param[in] checkpoint Checkpoint taken from the arena by `memory_arena_checkpoint`.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context.
+ * @note All memory allocated after the checkpoint was taken is invalidated.
+ */
+void memory_arena_rollback(MemoryArena **const arena, const MemoryArenaCheckpoint checkpoint);
+
 /**
  * @brief Moves memory from an external pointer into an arena allocation.
  *
@@ -216,4 +883,114 @@ void *memory_arena_move(MemoryArena **const arena, void **src, const size_t size
  */
 void *memory_arena_copy(MemoryArena **const arena, const void *const src, const size_t size);
 
+/**
+ * @brief Resizes an allocation, in place where possible.
+ *
+ * The allocation is grown or shrunk in place when it is the most recent allocation of the
+ * arena's active block and the new size fits in that block. VIRTUAL arenas commit more pages
+ * for it, so their most recent allocation can grow in place up to the end of the
+ * reservation. CONCURRENT arenas only resize in place while no other thread has allocated
+ * after `ptr`. POOL slots and SIZE_CLASS slots are resized in place up to their slot size.
+ * An allocation made before the latest stack mark, snapshot or checkpoint is never resized in
+ * place, so restoring, unwinding or rolling back to it can not cut the allocation short or
+ * hand its tail out again.
+ *
+ * Otherwise a smaller size leaves the allocation where it is, and a larger one is allocated
+ * anew and the first `old_size` bytes are copied over. The old memory of a POOL or SIZE_CLASS
+ * arena is then freed, in other arenas it stays allocated until the arena is reset.
+ *
+ * Passing `NULL` for `ptr` is equivalent to calling `memory_arena_alloc` with `new_size`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - new_size is zero, or old_size is zero while ptr is not `NULL`.
+ *
+ * The FAST check level skips these checks.
+ *
+ * @param[in,out] arena Pointer to the pointer of the arena the memory was allocated from.
+ * @param[in] ptr Memory previously allocated from the arena, or `NULL`.
+ * @param[in] old_size Size the memory was allocated or last resized with.
+ * @param[in] new_size Size to resize the memory to.
+ *
+ * @return Pointer to the resized memory, which is `ptr` if it was resized in place, or `NULL`
+ *         if the arena can not grow it, in which case `ptr` is left untouched.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ * @note This function is **NOT** thread safe and shouldn't be used in a concurrent context, unless
+ *       the arena was created with the CONCURRENT allocator type.
+ */
+void *__attribute__((warn_unused_result)) memory_arena_realloc(MemoryArena **const arena, void *const ptr,
+                                                               const size_t old_size, const size_t new_size);
+
+/**
+ * @brief Returns the calling thread's own memory arena.
+ *
+ * Each thread gets a LINEAR arena aligned to `max_align_t`, created lazily on the first call
+ * from that thread and destroyed automatically when the thread exits. Because the arena is
+ * private to its thread it can be used without any synchronization.
+ *
+ * Blocks released by thread arenas, like blocks released by any other arena, are parked in a
+ * process-wide recycler so that a thread creating an arena can reuse memory released by another
+ * thread instead of mapping fresh pages.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - the arena or its thread-exit hook can not be created.
+ *
+ * @return The calling thread's arena. The arena must not be destroyed with
+ *         `memory_arena_destroy`; use `memory_thread_arena_release` instead.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+MemoryArena *memory_thread_arena(void);
+
+/**
+ * @brief Destroys the calling thread's arena ahead of thread exit.
+ *
+ * All memory allocated from the thread arena is invalidated. A later call to
+ * `memory_thread_arena` on the same thread creates a new arena. Calling this function on a
+ * thread that has no arena is a no-op.
+ */
+void memory_thread_arena_release(void);
+
+/**
+ * @brief Returns the calling thread's arena, bound to a NUMA node.
+ *
+ * Like `memory_thread_arena`, but an arena created by this call has every block bound to
+ * `node` with `MEMORY_NUMA_BIND`. Threads pinned to the CPUs of one node can pass
+ * `memory_numa_node()` so that their arena stays local to them. Later calls to either
+ * function return the same arena.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `node` is not a node the process may allocate memory on.
+ * - the calling thread already has an arena that is not bound to `node`.
+ * - the arena or its thread-exit hook can not be created.
+ *
+ * @param[in] node NUMA node the arena's memory is placed on.
+ *
+ * @return The calling thread's arena, released like the one of `memory_thread_arena`.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+MemoryArena *memory_thread_arena_on_node(const size_t node);
+
+/**
+ * @brief Returns the NUMA node of the CPU the calling thread is running on.
+ *
+ * The thread may be moved to another CPU right after the call unless it is pinned.
+ *
+ * @return The node of the current CPU, or 0 if the system does not report one.
+ */
+size_t memory_numa_node(void);
+
+/**
+ * @brief Unmaps every memory block held by the process-wide block recycler.
+ *
+ * Released blocks are normally kept for reuse by other arenas. This function hands their
+ * memory back to the operating system, for example after a burst of work has finished.
+ */
+void memory_recycler_drain(void);
+
 #endif    // !ANVIL_MEMORY_ARENA_H
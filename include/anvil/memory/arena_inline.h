@@ -0,0 +1,129 @@
+/**
+ * @file arena_inline.h
+ * @brief Header-only allocation fast path for bump allocated memory arenas.
+ *
+ * `memory_arena_alloc` is an out-of-line call that dispatches on the allocator type and
+ * re-validates the arena on every allocation. The functions in this header instead bump the
+ * arena's active block directly and are specialized at compile time for one allocator type
+ * and one alignment, so an allocation that fits in the active block compiles down to a few
+ * instructions. Only allocations that do not fit call into the library, which grows the arena
+ * or returns `NULL` exactly as `memory_arena_alloc` does. Allocations are counted in the arena
+ * statistics on both paths.
+ *
+ * Use `MEMORY_ARENA_ALLOC_INLINE` with the allocator type and alignment the arena was created
+ * with, both as constants:
+ *
+ *     MemoryArena *arena = memory_arena_create(LINEAR, 16, 4096);
+ *     Node *node = MEMORY_ARENA_ALLOC_INLINE(&arena, LINEAR, 16, sizeof(Node));
+ *
+ * SCRATCH, LINEAR, STACK and VIRTUAL arenas have a fast path. Other allocator types fail to
+ * compile. Using a type or alignment that does not match the arena is undefined behaviour,
+ * which is checked by `assert` unless `NDEBUG` is defined.
+ */
+
+#ifndef ANVIL_MEMORY_ARENA_INLINE_H
+#define ANVIL_MEMORY_ARENA_INLINE_H
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Allocates `size` bytes from a memory arena through the inline fast path.
+ *
+ * @param arena     Pointer to the arena pointer, as passed to `memory_arena_alloc`.
+ * @param type      Allocator type of the arena: SCRATCH, LINEAR, STACK or VIRTUAL.
+ * @param alignment Alignment of the arena. Must be a constant power of two.
+ * @param size      Amount of memory to allocate.
+ *
+ * @return Pointer to the allocated memory, or `NULL` under the same conditions as
+ *         `memory_arena_alloc`.
+ */
+#define MEMORY_ARENA_ALLOC_INLINE(arena, type, alignment, size)                                                        \
+	__extension__({                                                                                                \
+		static_assert((alignment) != 0 && ((alignment) & ((alignment) - 1)) == 0,                              \
+		              "alignment must be a power of two");                                                     \
+		memory_arena_alloc_inline_##type((arena), (size), (alignment));                                        \
+	})
+
+/*
+ * Bumps `size` bytes at `alignment` out of `memory_block`, or returns NULL if the block does
+ * not have enough room left or `size` is zero.
+ */
+static inline __attribute__((always_inline)) void *memory_block_bump_inline(MemoryBlock *const memory_block,
+                                                                           const size_t size,
+                                                                           const size_t alignment) {
+	const uintptr_t current = (uintptr_t)memory_block->memory + memory_block->allocated;
+	const uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+	const size_t offset = (size_t)(aligned - current);
+	const size_t available = memory_block->capacity - memory_block->allocated;
+
+	if (__builtin_expect(size == 0 || offset > available || size > available - offset, 0)) {
+		return NULL;
+	}
+
+	memory_block->allocated += offset + size;
+	return (void *)aligned;
+}
+
+static inline __attribute__((always_inline)) void *
+memory_arena_alloc_inline_SCRATCH(MemoryArena **const arena, const size_t size, const size_t alignment) {
+	assert((*arena)->allocator_type == SCRATCH && (*arena)->alignment == alignment);
+
+	void *result = memory_block_bump_inline((*arena)->memory_block, size, alignment);
+	if (__builtin_expect(result != NULL, 1)) {
+		memory_arena_count(*arena, 1, size);
+		return result;
+	}
+	return memory_arena_alloc(arena, size);
+}
+
+static inline __attribute__((always_inline)) void *
+memory_arena_alloc_inline_LINEAR(MemoryArena **const arena, const size_t size, const size_t alignment) {
+	assert((*arena)->allocator_type == LINEAR && (*arena)->alignment == alignment);
+
+	void *result = memory_block_bump_inline((*arena)->state.linearAllocatorState.cursor, size, alignment);
+	if (__builtin_expect(result != NULL, 1)) {
+		memory_arena_count(*arena, 1, size);
+		return result;
+	}
+	return memory_arena_alloc(arena, size);
+}
+
+static inline __attribute__((always_inline)) void *
+memory_arena_alloc_inline_STACK(MemoryArena **const arena, const size_t size, const size_t alignment) {
+	assert((*arena)->allocator_type == STACK && (*arena)->alignment == alignment);
+
+	void *result = memory_block_bump_inline((*arena)->state.stackAllocatorState.top, size, alignment);
+	if (__builtin_expect(result != NULL, 1)) {
+		memory_arena_count(*arena, 1, size);
+		return result;
+	}
+	return memory_arena_alloc(arena, size);
+}
+
+static inline __attribute__((always_inline)) void *
+memory_arena_alloc_inline_VIRTUAL(MemoryArena **const arena, const size_t size, const size_t alignment) {
+	assert((*arena)->allocator_type == VIRTUAL && (*arena)->alignment == alignment);
+
+	/*
+	 * NOTE: VIRTUAL arenas pad every allocation to the alignment, and the fast path stays within
+	 * the committed pages so only the library ever commits memory.
+	 */
+	MemoryBlock *const memory_block = (*arena)->memory_block;
+	const size_t padded_size = (size + (alignment - 1)) & ~(alignment - 1);
+	const size_t committed = (*arena)->state.virtualAllocatorState.committed;
+
+	if (__builtin_expect(size != 0 && padded_size >= size && padded_size <= committed - memory_block->allocated,
+	                     1)) {
+		void *result = (char *)memory_block->memory + memory_block->allocated;
+		memory_block->allocated += padded_size;
+		memory_arena_count(*arena, 1, size);
+		return result;
+	}
+	return memory_arena_alloc(arena, size);
+}
+
+#endif    // !ANVIL_MEMORY_ARENA_INLINE_H
@@ -0,0 +1,71 @@
+/**
+ * @file block_recycler_internal.h
+ * @brief Internal process-wide recycler for released MemoryBlocks.
+ *
+ * The block recycler is a fixed array of slots shared by every thread in the process.
+ * Blocks released by one arena are parked in a free slot and can be picked up by any
+ * other arena, on any thread, instead of paying for an `munmap` followed by a fresh
+ * `mmap` and its page faults.
+ *
+ * Slots are claimed and filled with single atomic exchange / compare-exchange operations,
+ * so the recycler is lock-free. A block is only ever inspected by the thread that removed
+ * it from its slot, which keeps the design free of ABA hazards. A count of the occupied
+ * slots lets block creation skip the scan entirely while the recycler is empty.
+ */
+
+#ifndef ANVIL_MEMORY_BLOCK_RECYCLER_INTERNAL_H
+#define ANVIL_MEMORY_BLOCK_RECYCLER_INTERNAL_H
+
+#include "anvil/memory/internal/arena_internal.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Number of slots in the process-wide block recycler.
+ */
+#define BLOCK_RECYCLER_SLOTS          64
+
+/**
+ * @brief Largest block capacity the recycler will hold on to.
+ *
+ * Larger blocks are unmapped directly so the recycler never pins a large share of memory.
+ */
+#define BLOCK_RECYCLER_MAX_BLOCK_SIZE ((size_t)1 << 26)
+
+/**
+ * @brief Takes a recycled block able to hold `capacity` bytes at `alignment`.
+ *
+ * A recycled block is accepted if its memory satisfies `alignment`, its usable size is
+ * at least `capacity`, the capacity it was mapped with is less than twice `capacity`, and it is
+ * backed by huge pages exactly when `huge_pages` is set. The returned block has its capacity set to `capacity`,
+ * `allocated` set to zero and `next` set to `NULL`.
+ *
+ * @param[in] `capacity` Required usable capacity.
+ * @param[in] `alignment` Required memory alignment.
+ * @param[in] `huge_pages` Whether the block must be backed by huge pages.
+ *
+ * @return A recycled block, or `NULL` if no suitable block is parked.
+ */
+MemoryBlock *block_recycler_acquire(const size_t capacity, const size_t alignment, const bool huge_pages);
+
+/**
+ * @brief Offers a released block to the recycler.
+ *
+ * The memory the block handed out, including bytes an arena without reset zeroing rewound
+ * past, is zero-filled before it is parked, so recycled blocks are indistinguishable from
+ * freshly mapped ones.
+ *
+ * @param[in] `memory_block` Block to park.
+ *
+ * @return true if the recycler took ownership of the block, false if the caller must unmap it.
+ */
+bool block_recycler_release(MemoryBlock *const memory_block);
+
+/**
+ * @brief Unmaps every block currently parked in the recycler.
+ *
+ * @note Blocks released concurrently with a drain may be parked again afterwards.
+ */
+void block_recycler_drain(void);
+
+#endif    // !ANVIL_MEMORY_BLOCK_RECYCLER_INTERNAL_H
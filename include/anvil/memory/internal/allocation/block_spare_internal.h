@@ -0,0 +1,104 @@
+/**
+ * @file block_spare_internal.h
+ * @brief Internal spare blocks prepared ahead of time by a background refill thread.
+ *
+ * An arena created with `spare_block` owns a BlockSpare. A process-wide refill thread maps,
+ * places and prefaults one block for it ahead of time, so the next block the arena creates
+ * is taken with a single atomic exchange instead of an `mmap` and a run of page faults on
+ * the allocation path. Every block creation queues the preparation of the following spare,
+ * sized by the growth policy of the arena.
+ *
+ * The refill thread is started by the first refill request and lives until the process exits.
+ * The queue and the bookkeeping of every spare are protected by a single mutex, while the
+ * ready block itself is handed over atomically so taking it never blocks.
+ */
+
+#ifndef ANVIL_MEMORY_BLOCK_SPARE_INTERNAL_H
+#define ANVIL_MEMORY_BLOCK_SPARE_INTERNAL_H
+
+#include "anvil/memory/internal/arena_internal.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Spare block of an arena and its place in the refill queue.
+ *
+ * `mapping` is a copy of the arena's mapping policy without counters, limit or spare, so the
+ * refill thread never touches the arena itself. Only `ready` is accessed without the lock.
+ *
+ * Fields    | Type          | Size
+ * --------- | ------------- | -------------
+ * mapping   | MappingPolicy | 64 or 120 Bytes
+ * ready     | MemoryBlock * | 4 or 8 Bytes
+ * capacity  | size_t        | 4 or 8 Bytes
+ * alignment | size_t        | 4 or 8 Bytes
+ * next      | BlockSpare *  | 4 or 8 Bytes
+ * queued    | bool          | 1 Byte
+ * busy      | bool          | 1 Byte
+ * reused    | bool          | 1 Byte
+ */
+typedef struct BlockSpare {
+	MappingPolicy mapping;      ///< Placement and backing of the spare blocks.
+	MemoryBlock *ready;         ///< Prefaulted block waiting to be taken, NULL if none.
+	size_t capacity;            ///< Capacity of the next spare to prepare.
+	size_t alignment;           ///< Alignment of the spare blocks.
+	struct BlockSpare *next;    ///< Next spare in the refill queue.
+	bool queued;                ///< Waiting in the refill queue.
+	bool busy;                  ///< Being prepared by the refill thread.
+	bool reused;                ///< The ready block came from the block recycler.
+} BlockSpare;
+
+/**
+ * @brief Creates the spare of an arena, without preparing a block yet.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `mapping` is `NULL`.
+ * - `alignment` is not a power of two.
+ * - The system runs out of memory.
+ *
+ * @param[in] `mapping` Mapping policy of the arena, spare blocks are always prefaulted.
+ * @param[in] `alignment` Alignment the arena creates its blocks with.
+ *
+ * @return The spare, to be released with `block_spare_destroy`.
+ */
+BlockSpare *__attribute__((malloc, warn_unused_result)) block_spare_create(const MappingPolicy *const mapping,
+                                                                           const size_t alignment);
+
+/**
+ * @brief Takes the ready spare block if it can serve a block of `capacity` bytes.
+ *
+ * A ready block too small or not aligned to `alignment` is destroyed. The returned block has
+ * its capacity set to `capacity`, `allocated` set to zero and `next` set to `NULL`; it is not
+ * yet counted by any arena.
+ *
+ * @param[in] `spare` Spare of the arena.
+ * @param[in] `capacity` Required usable capacity.
+ * @param[in] `alignment` Required memory alignment.
+ * @param[out] `reused` Set to whether the returned block came from the block recycler.
+ *
+ * @return The spare block, or `NULL` if none is ready or it does not fit.
+ */
+MemoryBlock *block_spare_take(BlockSpare *const spare, const size_t capacity, const size_t alignment,
+                              bool *const reused);
+
+/**
+ * @brief Queues the preparation of a spare block of `capacity` bytes.
+ *
+ * Does nothing while a block is ready. A request made while a block is already being prepared
+ * only updates the capacity of the next one.
+ *
+ * @param[in] `spare` Spare of the arena.
+ * @param[in] `capacity` Capacity of the block to prepare.
+ */
+void block_spare_refill(BlockSpare *const spare, const size_t capacity);
+
+/**
+ * @brief Withdraws a spare from the refill queue, releases its ready block and frees it.
+ *
+ * Waits for the refill thread if it is preparing a block for this spare.
+ *
+ * @param[in] `spare` Spare to destroy.
+ */
+void block_spare_destroy(BlockSpare *const spare);
+
+#endif    // !ANVIL_MEMORY_BLOCK_SPARE_INTERNAL_H
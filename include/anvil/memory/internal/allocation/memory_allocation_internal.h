@@ -10,8 +10,15 @@
 #ifndef MEMORY_ALLOCATION_INTERNAL_H
 #define MEMORY_ALLOCATION_INTERNAL_H
 
-#include <stddef.h>
+#include "anvil/memory/arena.h"
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Size of the huge pages requested by `safe_aligned_alloc_huge`.
+ */
+#define HUGE_PAGE_SIZE ((size_t)1 << 21)
 
 /**
  * @brief Metadata
@@ -24,38 +31,234 @@
  * - capacity is larger than zero.
  * - memory is not null.
  *
- * Fields    | Type          | Size
- * --------- | ------------- | -------------
- * base      | void pointer  | 4 or 8 Bytes
- * size      | size_t        | 4 or 8 Bytes
+ * Fields    | Type              | Size
+ * --------- | ----------------- | -------------
+ * base      | void pointer      | 4 or 8 Bytes
+ * size      | size_t            | 4 or 8 Bytes
+ * backing   | MemoryPageBacking | 4 Bytes
  */
 typedef struct Metadata {
 	void *base;
 	size_t total_size;
+	MemoryPageBacking backing;
 } Metadata;
-static_assert(sizeof(Metadata) == 16 || sizeof(Metadata) == 8,
-              "Metadata should be 16 or 8 bytes depending on architecture");
+static_assert(sizeof(Metadata) == 24 || sizeof(Metadata) == 12,
+              "Metadata should be 24 or 12 bytes depending on architecture");
 static_assert(_Alignof(Metadata) == _Alignof(void *), "should have the natural alignment of a void pointer");
 
 /**
  * @brief Allocates an aligned block of memory.
  *
- * Allocate an aligned block of memory from a page.
+ * Allocate an aligned block of memory from a page. The first `header_size` bytes of the
+ * mapping are reserved for the caller, who can find them again with `safe_aligned_base`.
+ * This lets a caller keep its bookkeeping in the same mapping as the memory it describes.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - `size` is zero.
  * - `alignment` is not a power of two.
  * - `alignment` is larger than 2^16.
+ * - `header_size` is not a multiple of the alignment of `max_align_t`.
+ * - `size` plus the headers and alignment padding does not fit in a `size_t`.
  * - The system runs out of memory.
  *
  * @param[in] `size` of the allocation.
  * @param[in] `alignment` of the allocated memory.
+ * @param[in] `header_size` Bytes reserved for the caller at the start of the mapping.
  * @returns Pointer to allocated memory.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-void *__attribute__((malloc)) safe_aligned_alloc(const size_t size, const size_t alignment);
+void *__attribute__((malloc)) safe_aligned_alloc(const size_t size, const size_t alignment, const size_t header_size);
+
+/**
+ * @brief Allocates an aligned block of memory backed by huge pages.
+ *
+ * The mapping is rounded up to whole huge pages of `HUGE_PAGE_SIZE` and starts on a huge page
+ * boundary. Explicit `MAP_HUGETLB` pages are tried first. If the hugetlb pool can not serve
+ * the mapping, a regular mapping is trimmed to a huge page boundary and advised with
+ * `MADV_HUGEPAGE` so transparent huge pages can back it. The backing obtained is recorded and
+ * can be queried with `safe_aligned_page_backing`. The caller's header is reserved at the
+ * start of the mapping as with `safe_aligned_alloc`, and the memory starts
+ * `safe_aligned_header_size` bytes into the mapping.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `size` is zero or too large to be rounded up to whole huge pages.
+ * - `alignment` is not a power of two.
+ * - `alignment` is larger than 2^16.
+ * - `header_size` is not a multiple of the alignment of `max_align_t`.
+ * - The system runs out of memory.
+ *
+ * @param[in] `size` of the allocation.
+ * @param[in] `alignment` of the allocated memory.
+ * @param[in] `header_size` Bytes reserved for the caller at the start of the mapping.
+ * @returns Pointer to allocated memory.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc)) safe_aligned_alloc_huge(const size_t size, const size_t alignment,
+                                                      const size_t header_size);
+
+/**
+ * @brief Reserves an aligned range of address space without committing memory to it.
+ *
+ * The range is mapped `PROT_NONE` with `MAP_NORESERVE`, so it costs neither physical memory
+ * nor commit charge until parts of it are made accessible with `safe_aligned_commit`. Only the
+ * pages holding the caller's header and the metadata are accessible on return. With
+ * `huge_pages` the range is advised with `MADV_HUGEPAGE` so transparent huge pages can back it
+ * as it is committed. The range is released with `safe_aligned_free`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `size` is zero or too large to be reserved.
+ * - `alignment` is not a power of two.
+ * - `alignment` is larger than 2^16.
+ * - `header_size` is not a multiple of the alignment of `max_align_t`.
+ * - The system runs out of address space.
+ *
+ * @param[in] `size` of the range.
+ * @param[in] `alignment` of the range.
+ * @param[in] `header_size` Bytes reserved for the caller at the start of the mapping.
+ * @param[in] `huge_pages` Advise the range to use transparent huge pages.
+ * @returns Pointer to the start of the reserved range.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc)) safe_aligned_reserve(const size_t size, const size_t alignment,
+                                                   const size_t header_size, const bool huge_pages);
+
+/**
+ * @brief Commits the first `size` bytes of a range reserved with safe_aligned_reserve.
+ *
+ * Makes the pages between the end of the `committed` bytes and the end of the first `size`
+ * bytes readable and writable. Newly committed pages read as zero.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ * - `size` is larger than the reserved range.
+ * - The system runs out of memory.
+ *
+ * @param[in] `ptr` Pointer returned by safe_aligned_reserve.
+ * @param[in] `committed` Bytes from `ptr` that are already committed.
+ * @param[in] `size` Bytes from `ptr` that must be committed.
+ * @return Bytes from `ptr` committed after the call, `size` rounded up to the end of its page.
+ */
+size_t safe_aligned_commit(void *const ptr, const size_t committed, const size_t size);
+
+/**
+ * @brief Applies a NUMA placement policy to the whole mapping holding `ptr`.
+ *
+ * The policy is set with the `mbind` system call and covers the caller's header and the
+ * metadata as well as the memory. Pages that are already resident are moved to match it.
+ * `MEMORY_NUMA_DEFAULT` leaves the mapping untouched.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ * - `policy` is `MEMORY_NUMA_BIND` and `node` is not below `MEMORY_NUMA_MAX_NODES`.
+ *
+ * @param[in] `ptr` Pointer returned by safe_aligned_alloc, safe_aligned_alloc_huge or
+ *                  safe_aligned_reserve.
+ * @param[in] `policy` Placement of the pages of the mapping.
+ * @param[in] `node` Node the mapping is bound to with `MEMORY_NUMA_BIND`.
+ * @return true if the policy was applied, false if the kernel refused it.
+ */
+bool safe_aligned_bind(void *const ptr, const MemoryNumaPolicy policy, const size_t node);
+
+/**
+ * @brief Returns the whole mapping holding `ptr` to the default NUMA placement.
+ *
+ * Undoes `safe_aligned_bind`, so pages faulted in afterwards follow the policy of the
+ * faulting thread. Pages that are already resident stay where they are.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ *
+ * @param[in] `ptr` Pointer returned by safe_aligned_alloc or safe_aligned_alloc_huge.
+ * @return true if the policy was reset, false if the kernel refused it.
+ */
+bool safe_aligned_unbind(void *const ptr);
+
+/**
+ * @brief Faults in every page of the whole mapping holding `ptr` ahead of its first use.
+ *
+ * The pages are populated writable with `MADV_POPULATE_WRITE`, which follows the NUMA policy
+ * of the mapping, so the policy must be applied first. Kernels without it get one write to
+ * every page instead, which leaves the contents unchanged.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ *
+ * @param[in] `ptr` Pointer returned by safe_aligned_alloc or safe_aligned_alloc_huge.
+ */
+void safe_aligned_prefault(void *const ptr);
+
+/**
+ * @brief Checks if the process may allocate memory on a NUMA node.
+ *
+ * On kernels without NUMA support the only node is node 0.
+ *
+ * @param[in] `node` Node to check.
+ * @return true if `node` is one of the nodes allowed to the process, false otherwise.
+ */
+bool safe_numa_node_allowed(const size_t node);
+
+/**
+ * @brief Returns the NUMA node of the CPU the calling thread is running on.
+ *
+ * @return The node of the current CPU, or 0 if the system does not report one.
+ */
+size_t safe_numa_current_node(void);
+
+/**
+ * @brief Returns the offset of the memory from the start of a huge page backed mapping.
+ *
+ * Huge page backed mappings start on a huge page boundary, so the offset only depends on the
+ * caller's header, the metadata and the alignment.
+ *
+ * @param[in] `alignment` of the allocated memory.
+ * @param[in] `header_size` Bytes reserved for the caller at the start of the mapping.
+ * @return Offset of the memory from the start of the mapping.
+ */
+size_t __attribute__((const)) safe_aligned_header_size(const size_t alignment, const size_t header_size);
+
+/**
+ * @brief Returns the start of the mapping holding memory allocated with safe_aligned_alloc.
+ *
+ * This is where the caller's header reserved at allocation time lives.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ *
+ * @param[in] ptr Pointer returned by safe_aligned_alloc or safe_aligned_alloc_huge.
+ * @return The start of the mapping.
+ */
+void *__attribute__((pure)) safe_aligned_base(const void *const ptr);
+
+/**
+ * @brief Returns the page backing obtained for memory allocated with safe_aligned_alloc.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ *
+ * @param[in] ptr Pointer returned by safe_aligned_alloc or safe_aligned_alloc_huge.
+ * @return The page backing of the mapping.
+ */
+MemoryPageBacking __attribute__((pure)) safe_aligned_page_backing(const void *const ptr);
+
+/**
+ * @brief Returns the usable size of memory allocated with safe_aligned_alloc.
+ *
+ * The usable size spans from `ptr` to the end of the underlying mapping, which can be
+ * larger than the size originally requested because mappings are rounded up to whole pages.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `ptr` is `NULL`.
+ *
+ * @param[in] ptr Pointer returned by safe_aligned_alloc.
+ * @return Number of bytes usable from `ptr`.
+ */
+size_t __attribute__((pure)) safe_aligned_usable_size(const void *const ptr);
 
 /**
  * @brief Checks if a number is a power of two.
@@ -90,6 +293,9 @@ void safe_free(void *ptr);
  * via safe_aligned_alloc. It properly handles the metadata stored with the
  * allocation to ensure the correct memory address is freed.
  *
+ * The mapping is unmapped without being written to first, so the cost does not depend on
+ * how much of it was ever touched. Callers holding sensitive data must wipe it beforehand.
+ *
  * @param[in] ptr Pointer to the aligned memory to be freed.
  *
  * @note This function is safe to call with NULL, in which case no operation is performed.
@@ -98,4 +304,20 @@ void safe_free(void *ptr);
  */
 void safe_aligned_free(void *ptr);
 
+/**
+ * @brief Number of successful `mmap` calls made by the functions in this header.
+ *
+ * @return Calls made by the process since it started.
+ */
+size_t safe_mmap_calls(void);
+
+/**
+ * @brief Number of successful `munmap` calls made by the functions in this header.
+ *
+ * Trimming the unaligned ends of a huge page mapping counts as well as freeing a mapping.
+ *
+ * @return Calls made by the process since it started.
+ */
+size_t safe_munmap_calls(void);
+
 #endif    // !MEMORY_ALLOCATION_INTERNAL_H
@@ -0,0 +1,356 @@
+/**
+ * @file memory_block_internal.h
+ * @brief Internal MemoryBlock lifecycle functions for the Anvil Memory system.
+ *
+ * Every allocator obtains and releases its MemoryBlocks through the functions in this
+ * header rather than calling `safe_aligned_alloc` itself. This gives the library a single
+ * place where blocks are created and destroyed, which is where released blocks are handed
+ * to the process-wide block recycler and where recycled blocks are picked up again before
+ * falling back to a fresh mapping.
+ *
+ * A MemoryBlock lives at the start of the mapping it describes, followed by room for the
+ * MemoryArena that owns the block when it is the head of the arena's chain. Creating a block
+ * therefore costs a single `mmap` and no heap allocation, and a block's header shares the
+ * mapping with its data.
+ */
+
+#ifndef ANVIL_MEMORY_BLOCK_INTERNAL_H
+#define ANVIL_MEMORY_BLOCK_INTERNAL_H
+
+#include "anvil/memory/internal/arena_internal.h"
+#include <stddef.h>
+
+/**
+ * @brief Header at the start of every block mapping.
+ *
+ * The arena slot is only used by the head block of an arena. Every block reserves it, so
+ * any recycled block can become the head of a new arena.
+ *
+ * Fields | Type        | Size
+ * ------ | ----------- | -------------
+ * block  | MemoryBlock | 32 or 64 Bytes
+ * arena  | MemoryArena | 144 or 280 Bytes
+ */
+typedef struct {
+	MemoryBlock block;    ///< The block describing the mapping.
+	MemoryArena arena;    ///< The owning arena, if this is its head block.
+} MemoryBlockHeader;
+
+static_assert(_Alignof(MemoryBlockHeader) == _Alignof(MemoryBlock *),
+              "MemoryBlockHeader alignment must match MemoryBlock* alignment");
+
+/**
+ * @brief Bytes at the start of a MemoryBlock that may hold data.
+ *
+ * Covers the allocated bytes and any bytes a rewind without zeroing left behind, which must
+ * be cleared before the block can be handed to another arena.
+ *
+ * @param[in] `memory_block` Block to measure.
+ *
+ * @return The larger of the allocated bytes, clamped to the capacity, and the dirty bytes.
+ */
+static inline size_t memory_block_touched(const MemoryBlock *const memory_block) {
+	const size_t used =
+	    memory_block->allocated < memory_block->capacity ? memory_block->allocated : memory_block->capacity;
+	return used > memory_block->dirty ? used : memory_block->dirty;
+}
+
+/**
+ * @brief Bytes reserved for the MemoryBlockHeader at the start of every block mapping.
+ */
+#define MEMORY_BLOCK_HEADER_SIZE                                                                                       \
+	((sizeof(MemoryBlockHeader) + (_Alignof(max_align_t) - 1)) & ~(_Alignof(max_align_t) - 1))
+
+/**
+ * @brief Release threshold used when `MemoryArenaOptions.reset_release_threshold` is zero.
+ */
+#define RESET_RELEASE_DEFAULT_THRESHOLD ((size_t)1 << 20)
+
+/**
+ * @brief Creates a detached MemoryBlock with the given capacity and alignment.
+ *
+ * The block is the spare of the mapping policy when one is ready and large enough, then a
+ * block from the block recycler when a recycled block of a suitable size, alignment and page
+ * backing is available, otherwise a new block is mapped as described by the arena's mapping
+ * policy, with the block header placed at the start of the mapping.
+ * Blocks backed by huge pages have their capacity rounded up so the mapping fills whole huge
+ * pages. The returned block has `allocated` set to zero, `next` set to `NULL` and its memory
+ * is zero-filled. The page backing recorded in the mapping policy is lowered to the backing
+ * of the returned block, the block is added to the block counters of the policy and its pages
+ * are placed according to the policy's NUMA fields, then faulted in if the policy prefaults.
+ * With a spare, the preparation of the next one is queued, sized by `memory_block_next_capacity`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `capacity` is zero.
+ * - `alignment` is not a power of two.
+ * - `mapping` is `NULL`.
+ * - The system runs out of memory.
+ *
+ * @param[in] `capacity` Usable capacity of the block in bytes.
+ * @param[in] `alignment` Alignment of the block's memory.
+ * @param[in,out] `mapping` Mapping policy of the owning arena.
+ *
+ * @return Pointer to the new memory block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+MemoryBlock *__attribute__((malloc, warn_unused_result)) memory_block_create(const size_t capacity,
+                                                                             const size_t alignment,
+                                                                             MappingPolicy *const mapping);
+
+/**
+ * @brief Capacity a block created for `capacity` bytes at `alignment` is mapped with.
+ *
+ * Blocks backed by huge pages are rounded up so the block and its header fill whole huge
+ * pages, other blocks keep `capacity`. This is the capacity counted against the limit of the
+ * mapping policy.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `mapping` is `NULL`.
+ *
+ * @param[in] `mapping` Mapping policy of the arena.
+ * @param[in] `capacity` Capacity asked for.
+ * @param[in] `alignment` Alignment of the block's memory.
+ *
+ * @return Capacity of the block, or 0 if rounding it would overflow.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+size_t memory_block_mapped_capacity(const MappingPolicy *const mapping, const size_t capacity,
+                                    const size_t alignment);
+
+/**
+ * @brief Capacity of the block an arena grows by when its last block is full.
+ *
+ * The capacity is the fixed growth chunk of the mapping policy if one is set, otherwise the
+ * capacity of the last block times the growth factor. It is capped at the policy's largest
+ * block size, raised to `required` so the allocation that triggered the growth fits, and
+ * rounded up to `granule`. If the block would be larger than any mapping or, once rounded by
+ * `memory_block_mapped_capacity`, take the arena past its capacity limit, a block of exactly
+ * `required` bytes is tried instead.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `mapping` is `NULL`.
+ * - `granule` is not a power of two.
+ *
+ * @param[in] `mapping` Mapping policy of the arena.
+ * @param[in] `capacity` Capacity of the last block of the arena.
+ * @param[in] `required` Capacity the new block needs for the pending allocation.
+ * @param[in] `granule` Power of two the capacity is rounded up to.
+ *
+ * @return Capacity of the new block, or 0 if `required` is larger than `PTRDIFF_MAX` or the
+ *         capacity limit leaves no room for it.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+size_t memory_block_next_capacity(const MappingPolicy *const mapping, const size_t capacity, const size_t required,
+                                  const size_t granule);
+
+/**
+ * @brief Allocates `size` bytes from a block of their own on a side list of large blocks.
+ *
+ * A block of exactly `size` bytes, rounded up to `alignment`, is created as described by the
+ * mapping policy and pushed to the front of `large_blocks`. The allocation fills the block and
+ * starts at its first byte. The block counts against the capacity limit of the policy like any
+ * other block, but never becomes part of the arena's block chain.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `large_blocks` is `NULL`.
+ * - `size` is zero.
+ * - `alignment` is not a power of two.
+ * - `mapping` is `NULL`.
+ * - The system runs out of memory.
+ *
+ * @param[in,out] `large_blocks` Head of the arena's list of large blocks.
+ * @param[in] `size` Amount of memory to allocate.
+ * @param[in] `alignment` Alignment of the allocation.
+ * @param[in,out] `mapping` Mapping policy of the owning arena.
+ *
+ * @return Pointer to zero-filled memory, or NULL if `size` is larger than `PTRDIFF_MAX` or the
+ *         capacity limit leaves no room for the block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) memory_block_alloc_large(MemoryBlock **const large_blocks,
+                                                                           const size_t size, const size_t alignment,
+                                                                           MappingPolicy *const mapping);
+
+/**
+ * @brief Creates a MemoryBlock over reserved but uncommitted address space.
+ *
+ * The block's `capacity` bytes are reserved with `safe_aligned_reserve` and none of them are
+ * accessible until the owner commits them with `safe_aligned_commit`. The block header is
+ * placed at the start of the mapping as with `memory_block_create`. Reserved blocks never
+ * come from, or go to, the block recycler and must be released with `memory_block_unmap`.
+ * The block is added to the block counters of the mapping policy.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `capacity` is zero.
+ * - `alignment` is not a power of two.
+ * - `mapping` is `NULL`.
+ * - The system runs out of address space.
+ *
+ * @param[in] `capacity` Reserved capacity of the block in bytes.
+ * @param[in] `alignment` Alignment of the block's memory.
+ * @param[in,out] `mapping` Mapping policy of the owning arena.
+ *
+ * @return Pointer to the new memory block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+MemoryBlock *__attribute__((malloc, warn_unused_result)) memory_block_reserve(const size_t capacity,
+                                                                              const size_t alignment,
+                                                                              MappingPolicy *const mapping);
+
+/**
+ * @brief Releases a single MemoryBlock.
+ *
+ * The used bytes of a sensitive block are wiped first. The block is then offered to the
+ * block recycler and only unmapped if the recycler declines it. The `next` link of the
+ * block is ignored.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ *
+ * @param[in] `memory_block` Block to release.
+ *
+ * @return `true` if the block was unmapped, `false` if the recycler kept it.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+bool memory_block_destroy(MemoryBlock *const memory_block);
+
+/**
+ * @brief Releases a chain of MemoryBlocks that an arena gives up before it is destroyed.
+ *
+ * Every block from `memory_block` to the end of its chain is released with
+ * `memory_block_destroy` and removed from the block counters of the arena's mapping policy,
+ * which also count the blocks that were unmapped rather than recycled.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ * - `mapping` is `NULL`.
+ *
+ * @param[in] `memory_block` First block of the chain to release.
+ * @param[in,out] `mapping` Mapping policy of the owning arena.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void memory_block_chain_release(MemoryBlock *const memory_block, MappingPolicy *const mapping);
+
+/**
+ * @brief Resets a MemoryBlock chain according to a reset policy.
+ *
+ * The head block is always kept. Following blocks are kept while the policy's block count
+ * and byte budget allow, and every kept block has its used memory cleared according to the
+ * policy's zeroing mode and its allocation counter rewound. The remaining blocks are released
+ * with `memory_block_chain_release`. When the policy has a decay period and the last kept
+ * block went unused for that many consecutive resets, it is released as well.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ * - `policy` is `NULL`.
+ * - `mapping` is `NULL`.
+ *
+ * @param[in,out] `memory_block` Head of the chain to reset.
+ * @param[in,out] `policy` Reset policy of the owning arena.
+ * @param[in,out] `mapping` Mapping policy of the owning arena.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void memory_block_chain_reset(MemoryBlock *const memory_block, ResetPolicy *const policy,
+                              MappingPolicy *const mapping);
+
+/**
+ * @brief Clears the first `size` bytes of a MemoryBlock.
+ *
+ * Eager zeroing writes every byte. In release mode a range of at least `release_threshold`
+ * bytes has its whole pages handed back to the kernel with `MADV_DONTNEED`, so they read as
+ * zero on the next touch without being written now; only the partial pages at either end
+ * are zeroed. Huge page backed blocks are released in whole huge pages. If the kernel
+ * refuses the advice the range is zeroed eagerly.
+ *
+ * @param[in,out] `memory_block` Block to clear.
+ * @param[in] `size` Number of bytes from the start of the block to clear.
+ * @param[in] `zeroing` Zeroing mode to apply.
+ * @param[in] `release_threshold` Smallest range released rather than zeroed in release mode.
+ */
+void memory_block_zero(MemoryBlock *const memory_block, const size_t size, const MemoryResetZeroing zeroing,
+                       const size_t release_threshold);
+
+/**
+ * @brief Rewinds the allocation offset of a MemoryBlock to `offset`.
+ *
+ * The bytes from `offset` to the old offset are cleared according to the policy's zeroing
+ * mode, so memory past the offset reads as zero when it is handed out again. Without zeroing
+ * they are left as they are and the block's dirty high water is raised over them instead, so
+ * the recycler still clears them before another arena can take the block. The block is
+ * pinned at `offset`, the position of the mark it was rewound to, or the start of the block.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ * - `policy` is `NULL`.
+ *
+ * @param[in,out] `memory_block` Block to rewind.
+ * @param[in] `offset` New allocation offset, at most the current one.
+ * @param[in] `policy` Reset policy of the owning arena.
+ */
+void memory_block_rewind(MemoryBlock *const memory_block, const size_t offset, const ResetPolicy *const policy);
+
+/**
+ * @brief Unmaps a single MemoryBlock without offering it to the block recycler.
+ *
+ * The used bytes of a sensitive block are wiped first, other blocks are unmapped without
+ * touching their memory.
+ *
+ * @param[in] `memory_block` Block to unmap. Safe to call with `NULL`.
+ */
+void memory_block_unmap(MemoryBlock *const memory_block);
+
+/**
+ * @brief Returns the arena slot in the mapping of a MemoryBlock.
+ *
+ * The slot is only meaningful for the head block of an arena, where it holds the arena itself.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ *
+ * @param[in] `memory_block` Block whose arena slot is returned.
+ *
+ * @return Pointer to the arena slot.
+ */
+MemoryArena *memory_block_arena(MemoryBlock *const memory_block);
+
+/**
+ * @brief Resizes the most recent allocation of a MemoryBlock in place.
+ *
+ * The allocation is the most recent one if it ends exactly at the block's allocation offset.
+ * The offset is then moved to `ptr + new_size`, growing or shrinking the allocation. The
+ * bytes released by shrinking are zeroed, since reset only clears memory below the offset.
+ * An allocation starting below the block's pinned offset was made before a mark that may
+ * still be restored, moving the offset would move it across the mark, so it is refused.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ * - `ptr` is `NULL`.
+ *
+ * @param[in,out] `memory_block` Block the allocation may have come from.
+ * @param[in] `ptr` Start of the allocation.
+ * @param[in] `old_size` Size the allocation was made with.
+ * @param[in] `new_size` Size to resize the allocation to.
+ *
+ * @return true if the allocation was resized, false if it is not the most recent allocation
+ *         of the block, starts below the pinned offset or `new_size` does not fit in the block.
+ */
+bool memory_block_resize_last(MemoryBlock *const memory_block, void *const ptr, const size_t old_size,
+                              const size_t new_size);
+
+#endif    // !ANVIL_MEMORY_BLOCK_INTERNAL_H
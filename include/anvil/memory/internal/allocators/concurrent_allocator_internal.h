@@ -0,0 +1,165 @@
+/**
+ * @file concurrent_allocator_internal.h
+ * @brief Internal implementation of the Concurrent Memory Allocator.
+ *
+ * This header defines the internal functions for the Concurrent Allocator strategy, a
+ * lock-free variant of the Linear allocator that may be shared between threads. Space is
+ * claimed from the current tail block with a single atomic fetch-add, so concurrent
+ * allocations never wait on each other. Only block growth, which is rare, is serialized
+ * through a small spin lock held in the arena state.
+ *
+ * Every claim is rounded up to a multiple of the arena alignment, which keeps each offset
+ * inside a block aligned without re-reading the block state after the fetch-add.
+ */
+
+#ifndef ANVIL_MEMORY_CONCURRENT_ALLOCATOR_INTERNAL_H
+#define ANVIL_MEMORY_CONCURRENT_ALLOCATOR_INTERNAL_H
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include <stddef.h>
+
+/*****************************************************************************************************
+ *					Concurrent Allocator
+ * ***************************************************************************************************/
+
+/**
+ * @brief Concurrent memory free strategy for memory allocator.
+ *
+ * This function walks through all memory blocks in a memory block chain
+ * and frees them, including the memory they point to and the blocks themselves.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - head memory block in the memory block chain is `NULL`.
+ *
+ * @param [in] `memory_block` Pointer to the head of the memory block chain to free.
+ *
+ * @note This function must not race with allocations on the same arena.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void concurrent_free(MemoryBlock *const memory_block);
+
+/**
+ * @brief Concurrent memory reset strategy for memory allocator.
+ *
+ * This function will reset the first memory block in a memory block chain and rewind or
+ * free the rest of the memory blocks according to the arena's reset policy. Failed claims
+ * may push a block's `allocated` counter past its capacity, so the amount of memory cleared
+ * is clamped to the capacity.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - head memory block in the memory block chain is `NULL`.
+ *
+ * @param [in] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
+ *
+ * @note This function must not race with allocations on the same arena.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void concurrent_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
+
+/**
+ * @brief Concurrent memory allocation strategy for memory allocator.
+ *
+ * This function claims `allocation_size` bytes, rounded up to the arena alignment, from the
+ * current block with an atomic fetch-add. If the claim overruns the block, the calling
+ * thread takes the growth lock, moves on to the next block retained by a reset or appends a
+ * block of at least double capacity (unless another thread already did) and retries the
+ * claim on the new current block.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - The memory_block in the arena is `NULL`.
+ * - The arena alignment provided is not a power of two.
+ * - The allocation size is zero or overflows when rounded up to the alignment.
+ * - The system runs out of memory while growing.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ *
+ * @returns Pointer to allocated memory.
+ * @returns NULL if the capacity limit of the arena leaves no room for a new block.
+ *
+ * @note This function is safe to call concurrently from any number of threads.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) concurrent_alloc(MemoryArena **const arena,
+                                                                   const size_t allocation_size);
+
+/**
+ * @brief Concurrent memory allocation strategy with a per-allocation alignment.
+ *
+ * This function behaves like `concurrent_alloc` but aligns the allocation to `alignment`.
+ * Claims are always a multiple of the arena alignment apart, so the claim is widened by the
+ * difference between the two alignments, which is the most padding the allocation can need.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - The memory_block in the arena is `NULL`.
+ * - The alignment is not a power of two or smaller than the arena alignment.
+ * - The allocation size is zero or overflows when padded to the alignment.
+ * - The system runs out of memory while growing.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ * @param [in] `alignment` Alignment of the allocation.
+ *
+ * @returns Pointer to allocated memory.
+ * @returns NULL if the capacity limit of the arena leaves no room for a new block.
+ *
+ * @note This function is safe to call concurrently from any number of threads.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) concurrent_alloc_aligned(MemoryArena **const arena,
+                                                                           const size_t allocation_size,
+                                                                           const size_t alignment);
+
+/**
+ * @brief Resizes the most recent claim of the current block in place.
+ *
+ * The claim of `ptr` is moved from `old_size` to `new_size`, both rounded up to the arena
+ * alignment, with a compare-and-swap on the allocation offset of the current block. The swap
+ * fails if another thread claimed memory after `ptr`, so a resize never overlaps a claim.
+ * Bytes released by shrinking are zeroed before the swap makes them claimable.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - `ptr` is `NULL`.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena the memory was allocated from.
+ * @param [in] `ptr` Memory previously returned by the arena.
+ * @param [in] `old_size` Size the allocation was made with.
+ * @param [in] `new_size` Size to resize the allocation to.
+ *
+ * @return true if the allocation was resized in place, false otherwise.
+ *
+ * @note This function is safe to call concurrently with allocations from other threads.
+ */
+bool concurrent_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size);
+
+/**
+ * @brief Concurrent memory allocation verification function.
+ *
+ * Like the linear allocator, the concurrent allocator grows on demand and therefore
+ * reports that an allocation can be satisfied unless it does not fit the current block and
+ * the arena's capacity limit leaves no room for a new one. The allocation is checked as the
+ * claim it would make, padded to a multiple of the arena alignment.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - Arena is `NULL`.
+ * - Allocation size is zero.
+ *
+ * @param [in] `arena` Pointer to the arena to check for allocation possibility.
+ * @param [in] `allocation_size` Size of the potential allocation.
+ *
+ * @return true unless the capacity limit prevents the arena from growing to hold the
+ *         allocation.
+ */
+bool __attribute__((pure)) concurrent_alloc_verify(MemoryArena *const arena, const size_t allocation_size);
+
+#endif    // !ANVIL_MEMORY_CONCURRENT_ALLOCATOR_INTERNAL_H
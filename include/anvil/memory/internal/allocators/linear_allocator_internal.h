@@ -39,54 +39,86 @@ void linear_free(MemoryBlock *const memory_block);
  * @brief Linear memory reset strategy for memory allocator.
  *
  * This function will reset the first memory block in a memory block chain.
- * It will free the rest of the memory blocks. This returns the memory
- * block chain to the state it was at when it was first created.
+ * The rest of the memory blocks are rewound or freed according to the arena's
+ * reset policy. With the default policy this returns the memory block chain to
+ * the state it was at when it was first created.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - head memory block in the memory block chain is `NULL`.
  *
  * @param [out] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-void linear_reset(MemoryBlock *const memory_block);
+void linear_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
 
 /**
  * @brief Linear memory allocation strategy for memory allocator.
  *
- * This function traverses a chain of memory blocks and allocates memory from the
- * first memory block for which there is enough memory available to handle the allocation.
- * If no existing block can handle the allocation, it creates a new block with doubled
- * capacity and links it to the chain. This ensures the allocator can always satisfy
- * memory requests as long as the system has memory available.
+ * This function allocates memory from the arena's active block, so the common case only
+ * touches a single block regardless of how long the chain is. If the active block is full
+ * and the arena is in best-fit mode, the earlier block with the tightest fit is used instead.
+ * An allocation above the arena's large threshold then gets a block of its own on the arena's
+ * list of large blocks. Otherwise the cursor moves on to the next block, creating a new block sized by the arena's
+ * growth policy when it reaches the end of the chain. The allocator can satisfy any request
+ * as long as the system has memory available and the arena's capacity limit allows it.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - arena or *arena is `NULL`.
  * - The memory_block in the arena is `NULL`.
  * - The memory pointer within the block is `NULL`.
  * - The arena alignment provided is not a power of two.
- * - The arena alignment is not >= the alignment of `max_align_t`.
  * - The allocation size is zero.
  *
  * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
  * @param [in] `allocation_size` Amount of memory to allocate from the memory block.
  *
  * @returns Pointer to allocated memory.
- * @returns NULL if system is out of memory.
+ * @returns NULL if the capacity limit of the arena leaves no room for a new block.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
 void *__attribute__((malloc, warn_unused_result)) linear_alloc(MemoryArena **const arena, const size_t allocation_size);
 
+/**
+ * @brief Linear memory allocation strategy with a per-allocation alignment.
+ *
+ * This function behaves like `linear_alloc` but aligns the allocation to `alignment` instead
+ * of the arena alignment. Blocks created to serve the allocation are aligned to `alignment`,
+ * so growing the arena once is always enough.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - The memory_block in the arena is `NULL`.
+ * - The alignment is not a power of two.
+ * - The allocation size is zero.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate from the memory block.
+ * @param [in] `alignment` Alignment of the allocation, at least the arena alignment.
+ *
+ * @returns Pointer to allocated memory.
+ * @returns NULL if the capacity limit of the arena leaves no room for a new block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) linear_alloc_aligned(MemoryArena **const arena,
+                                                                       const size_t allocation_size,
+                                                                       const size_t alignment);
+
 /**
  * @brief Linear memory allocation verification function.
  *
  * This function checks if an allocation of the given size is possible with the
- * current memory arena. For the linear allocator, this function always returns `true`
- * because it can dynamically create new blocks when needed, effectively only failing
- * if the system runs out of memory (which would trigger a crash via the INVARIANT macros).
+ * current memory arena. The linear allocator creates new blocks when needed, so this only
+ * returns `false` when the allocation does not fit the active block and the arena's capacity
+ * limit leaves no room for a block that holds it. Running out of system memory triggers a
+ * crash via the INVARIANT macros instead.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - Arena is `NULL`.
@@ -95,8 +127,8 @@ void *__attribute__((malloc, warn_unused_result)) linear_alloc(MemoryArena **con
  * @param [in] `arena` Pointer to the arena to check for allocation possibility.
  * @param [in] `allocation_size` Size of the potential allocation.
  *
- * @return Always returns true for the linear allocator, as it can dynamically grow
- *         by allocating new blocks when needed.
+ * @return true unless the capacity limit prevents the arena from growing to hold the
+ *         allocation.
  */
 bool __attribute__((pure)) linear_alloc_verify(MemoryArena *const arena, const size_t allocation_size);
 
@@ -1,3 +1,17 @@
+/**
+ * @file pool_allocator_internal.h
+ * @brief Internal implementation of the Pool Memory Allocator.
+ *
+ * The Pool allocator is a slab allocator handing out fixed-size slots. The slot size is
+ * chosen when the arena is created and rounded up to the arena alignment, so every slot
+ * is aligned. Freed slots are pushed onto an intrusive free list whose link is stored in
+ * the first word of the freed slot itself, which keeps allocation and free O(1) without
+ * any per-slot bookkeeping outside of the slot being handed out or returned.
+ *
+ * Slots that have never been handed out are carved from the arena's active block, which
+ * grows into the next block of doubled capacity once it is full.
+ */
+
 #ifndef ANVIL_MEMORY_POOL_ALLOCATOR_INTERNAL_H
 #define ANVIL_MEMORY_POOL_ALLOCATOR_INTERNAL_H
 
@@ -29,53 +43,80 @@ void pool_free(MemoryBlock *const memory_block);
  * @brief Pool memory reset strategy for memory allocator.
  *
  * This function will reset the first memory block in a memory block chain.
- * It will free the rest of the memory blocks. This returns the memory
- * block chain to the state it was at when it was first created.
+ * The rest of the memory blocks are rewound or freed according to the arena's
+ * reset policy. With the default policy this returns the memory block chain to
+ * the state it was at when it was first created.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - head memory block in the memory block chain is `NULL`.
  *
  * @param [in] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-void pool_reset(MemoryBlock *const memory_block);
+void pool_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
 
 /**
  * @brief Pool memory allocation strategy for memory allocator.
  *
- * This function allocates memory from a memory block in pool-sized chunks.
- * It always allocates memory in multiples of the pool size, rounding up
- * the requested allocation size to the nearest pool boundary. If there is
- * not enough space in the current block, it moves to the next block or creates
- * a new one with doubled capacity.
+ * This function hands out a single slot. The most recently freed slot is reused first;
+ * its free list link is cleared so the returned slot is zero-filled, unless the arena does
+ * not zero on reset and the slot keeps what was written to it before. If the free list is
+ * empty a new slot is carved from the active block, moving on to the next block or a new
+ * one sized by the arena's growth policy when the active block is full. Slots above the
+ * arena's large threshold get a block of their own instead of a new block in the chain.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - arena is `NULL` or points to `NULL`.
  * - The arena's memory block is `NULL`.
  * - The arena's memory block's memory is `NULL`.
  * - The alignment provided is not a power of two.
- * - The alignment is not >= the alignment of `max_align_t`.
  * - The allocation size is zero.
  *
  * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
- * @param [in] `allocation_size` Amount of memory to allocate from the memory block.
+ * @param [in] `allocation_size` Amount of memory to allocate, at most the slot size.
  *
- * @return Pointer to allocated memory. This function will never return NULL as it
- *         will either allocate from an existing block or create a new one.
+ * @return Pointer to a zero-filled slot, or `NULL` if `allocation_size` is larger than
+ *         the slot size of the pool or the capacity limit of the arena leaves no room for a
+ *         new block.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
 void *pool_alloc(MemoryArena **const arena, const size_t allocation_size);
 
+/**
+ * @brief Pool memory deallocation strategy for memory allocator.
+ *
+ * This function zero-fills the slot and pushes it onto the free list of the pool so the
+ * next allocation reuses it. Only the freed slot is written to. Arenas created with
+ * `MEMORY_RESET_ZERO_NONE` skip the zero-fill and only write the free list link, so the
+ * free is O(1) regardless of the slot size.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - `ptr` is `NULL`.
+ * - `ptr` is not aligned to the arena alignment.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena the slot was allocated from.
+ * @param [in] `ptr` Slot previously returned by `pool_alloc` on the same arena and not yet freed.
+ *
+ * @note Freeing a pointer that was not handed out by this arena, or freeing it twice, corrupts
+ *       the free list and is not detected.
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void pool_dealloc(MemoryArena **const arena, void *const ptr);
+
 /**
  * @brief Pool memory allocation test strategy.
  *
- * This function verifies if an allocation of the given size could be made
- * from the arena. For the pool allocator, this function always returns true
- * because it can dynamically allocate new blocks when needed.
+ * This function verifies if an allocation of the given size could be made from the
+ * arena. The pool grows on demand, so this is the case when the allocation fits in a
+ * single slot and either a slot is free or the capacity limit leaves room to grow.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - arena is `NULL`.
@@ -86,8 +127,8 @@ void *pool_alloc(MemoryArena **const arena, const size_t allocation_size);
  * @param [in] `arena` The memory arena to check for allocation possibility.
  * @param [in] `allocation_size` Amount of memory to check for allocation possibility.
  *
- * @return Always returns true for pool allocator, as it can dynamically grow by
- *         allocating new blocks when needed.
+ * @return true if `allocation_size` is at most the slot size of the pool and a slot can be
+ *         handed out, false otherwise.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
@@ -51,11 +51,13 @@ void scratch_free(MemoryBlock *const memory_block);
  * - head memory block in the memory block chain is `NULL`.
  *
  * @param [out] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-void scratch_reset(MemoryBlock *const memory_block);
+void scratch_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
 
 /**
  * @brief Scratch memory allocation strategy for memory allocator.
@@ -69,7 +71,6 @@ void scratch_reset(MemoryBlock *const memory_block);
  * - The arena's memory block is NULL.
  * - The arena's memory block's memory is NULL.
  * - The arena's alignment is not a power of two.
- * - The arena's alignment is not >= the alignment of `max_align_t`.
  * - The allocation size is zero.
  *
  * @param [in,out] `arena` Pointer to the pointer of the memory arena.
@@ -82,6 +83,32 @@ void scratch_reset(MemoryBlock *const memory_block);
  */
 void *__attribute__((malloc, warn_unused_result)) scratch_alloc(MemoryArena **const arena, const size_t allocation_size);
 
+/**
+ * @brief Scratch memory allocation strategy with a per-allocation alignment.
+ *
+ * This function behaves like `scratch_alloc` but aligns the allocation to `alignment` instead
+ * of the arena alignment. The padding needed to reach the alignment counts against the head
+ * memory block.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is NULL or points to NULL.
+ * - The arena's memory block is NULL.
+ * - The alignment is not a power of two.
+ * - The allocation size is zero.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the memory arena.
+ * @param [in] `allocation_size` Amount of memory to allocate from the memory block.
+ * @param [in] `alignment` Alignment of the allocation, at least the arena alignment.
+ *
+ * @return Pointer to allocated memory, or NULL if there isn't enough space.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) scratch_alloc_aligned(MemoryArena **const arena,
+                                                                        const size_t allocation_size,
+                                                                        const size_t alignment);
+
 /**
  * @brief Scratch memory allocation test strategy.
  *
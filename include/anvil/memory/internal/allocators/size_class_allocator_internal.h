@@ -0,0 +1,278 @@
+/**
+ * @file size_class_allocator_internal.h
+ * @brief Internal implementation of the Size Class Memory Allocator.
+ *
+ * The Size Class allocator serves small objects from a fixed set of jemalloc-style size
+ * classes: steps of 16 bytes up to 128 bytes, then four classes per doubling up to 512 bytes.
+ * Each class hands out slots from runs, fixed-size spans carved out of the arena's memory
+ * blocks. Every run starts with a header naming its class, and runs are aligned to their own
+ * size, so the class of any pointer is found by masking off the low bits of its address.
+ *
+ * Freed slots are pushed onto an intrusive free list per class, linked through the first word
+ * of the slot, so allocation and free are O(1). Requests larger than the biggest class are
+ * bumped out of shared large runs, or given a dedicated span if they do not fit in a run.
+ * Large allocations are only reclaimed by reset, freeing them is a no-op.
+ */
+
+#ifndef ANVIL_MEMORY_SIZE_CLASS_ALLOCATOR_INTERNAL_H
+#define ANVIL_MEMORY_SIZE_CLASS_ALLOCATOR_INTERNAL_H
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include <assert.h>
+#include <stddef.h>
+
+/**
+ * @brief Size and alignment of a run. Arena blocks of size class arenas are aligned to it.
+ */
+#define SIZE_CLASS_RUN_SIZE  ((size_t)1 << 16)
+
+/**
+ * @brief Largest allocation served from a size class, larger ones are large allocations.
+ */
+#define SIZE_CLASS_MAX_SIZE  ((size_t)512)
+
+/**
+ * @brief Size class value marking a run holding large allocations.
+ */
+#define SIZE_CLASS_LARGE     ((size_t)MEMORY_SIZE_CLASS_COUNT)
+
+/**
+ * @brief Header placed at the start of every run.
+ *
+ * Fields     | Type   | Size
+ * ---------- | ------ | -------------
+ * size_class | size_t | 4 or 8 Bytes
+ */
+typedef struct {
+	size_t size_class;    ///< Index of the class the run belongs to, or `SIZE_CLASS_LARGE`.
+} SizeClassRunHeader;
+
+/**
+ * @brief Bookkeeping of a single size class.
+ *
+ * Fields    | Type   | Size
+ * --------- | ------ | -------------
+ * free_list | void*  | 4 or 8 Bytes
+ * bump      | char*  | 4 or 8 Bytes
+ * end       | char*  | 4 or 8 Bytes
+ * slot_size | size_t | 4 or 8 Bytes
+ * runs      | size_t | 4 or 8 Bytes
+ * slots     | size_t | 4 or 8 Bytes
+ * live      | size_t | 4 or 8 Bytes
+ */
+typedef struct {
+	void *free_list;     ///< Most recently freed slot, linked through its first word.
+	char *bump;          ///< Next never used slot of the newest run.
+	char *end;           ///< End of the slots of the newest run.
+	size_t slot_size;    ///< Size of every slot of the class.
+	size_t runs;         ///< Runs carved for the class since the last reset.
+	size_t slots;        ///< Slots in those runs.
+	size_t live;         ///< Slots currently handed out.
+} SizeClass;
+
+static_assert(sizeof(SizeClass) == 28 || sizeof(SizeClass) == 56,
+              "SizeClass must be either 28 or 56 bytes depending on architecture");
+
+/**
+ * @brief Heap allocated state of a size class arena.
+ *
+ * Fields      | Type      | Size
+ * ----------- | --------- | -------------------------------
+ * classes     | SizeClass | MEMORY_SIZE_CLASS_COUNT entries
+ * large_bump  | char*     | 4 or 8 Bytes
+ * large_end   | char*     | 4 or 8 Bytes
+ * data_offset | size_t    | 4 or 8 Bytes
+ */
+typedef struct SizeClassTable {
+	SizeClass classes[MEMORY_SIZE_CLASS_COUNT];    ///< Per class bookkeeping.
+	char *large_bump;                              ///< Next free byte of the current large run.
+	char *large_end;                               ///< End of the current large run.
+	size_t data_offset;                            ///< Offset of the first slot from the run header.
+} SizeClassTable;
+
+/*****************************************************************************************************
+ *					Size Class Allocator
+ * ***************************************************************************************************/
+
+/**
+ * @brief Creates the size class table of a new size class arena.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `alignment` is not a power of two or not smaller than `SIZE_CLASS_RUN_SIZE`.
+ * - The system runs out of memory.
+ *
+ * @param [in] `alignment` Alignment of the arena.
+ *
+ * @return Pointer to the new table, released with `free`.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+SizeClassTable *__attribute__((malloc, warn_unused_result)) size_class_table_create(const size_t alignment);
+
+/**
+ * @brief Size class memory free strategy for memory allocator.
+ *
+ * This function walks through all memory blocks in a memory block chain and frees them.
+ * The size class table is released by the caller.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - head memory block in the memory block chain is `NULL`.
+ *
+ * @param [in] `memory_block` Pointer to the head of the memory block chain to free.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void size_class_free(MemoryBlock *const memory_block);
+
+/**
+ * @brief Size class memory reset strategy for memory allocator.
+ *
+ * This function resets the memory block chain according to the arena's reset policy and
+ * empties every size class, dropping all runs and free lists.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - head memory block in the memory block chain is `NULL`.
+ * - `table` is `NULL`.
+ *
+ * @param [in] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `table` Size class table of the arena.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void size_class_reset(MemoryBlock *const memory_block, SizeClassTable *const table, ResetPolicy *const policy,
+                      MappingPolicy *const mapping);
+
+/**
+ * @brief Size class memory allocation strategy for memory allocator.
+ *
+ * This function rounds `allocation_size` up to the arena alignment and serves it from the
+ * smallest class that fits. The most recently freed slot of the class is reused first,
+ * otherwise the next slot of the class's newest run is handed out, carving a new run from
+ * the active block when that run is full. Requests larger than `SIZE_CLASS_MAX_SIZE` are
+ * large allocations.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - The arena's memory block is `NULL`.
+ * - The allocation size is zero or too large to be rounded up to whole runs.
+ * - The system runs out of memory while growing.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ *
+ * @return Pointer to zero-filled memory, or NULL if the capacity limit of the arena leaves no
+ *         room for a new block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) size_class_alloc(MemoryArena **const arena,
+                                                                   const size_t allocation_size);
+
+/**
+ * @brief Size class memory allocation strategy with a per-allocation alignment.
+ *
+ * Slots are only aligned to the arena alignment, so an allocation with a stricter
+ * `alignment` is always served as a large allocation, padded to `alignment` within a large
+ * run or given a dedicated span. Freeing it is a no-op. Alignments up to the arena alignment
+ * behave exactly like `size_class_alloc`.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - The arena's memory block is `NULL`.
+ * - The alignment is not a power of two or larger than `SIZE_CLASS_RUN_SIZE`.
+ * - The allocation size is zero or too large to be rounded up to whole runs.
+ * - The system runs out of memory while growing.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ * @param [in] `alignment` Alignment of the allocation.
+ *
+ * @return Pointer to zero-filled memory, or NULL if the capacity limit of the arena leaves no
+ *         room for a new block.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) size_class_alloc_aligned(MemoryArena **const arena,
+                                                                           const size_t allocation_size,
+                                                                           const size_t alignment);
+
+/**
+ * @brief Size class memory deallocation strategy for memory allocator.
+ *
+ * This function finds the run of `ptr` from its address. Slots of a size class are
+ * zero-filled and pushed onto the free list of their class, large allocations are left
+ * alone until the arena is reset.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - `ptr` is `NULL` or not aligned to the arena alignment.
+ * - The class of `ptr` has no live slots.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena the memory was allocated from.
+ * @param [in] `ptr` Memory previously returned by `size_class_alloc` on the same arena.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void size_class_dealloc(MemoryArena **const arena, void *const ptr);
+
+/**
+ * @brief Resizes a size class allocation in place.
+ *
+ * A slot of a size class can be resized to anything up to its slot size. A large allocation
+ * can be resized if it is the most recent allocation of the current large run and the new
+ * size fits in the run. Bytes released by shrinking it are zeroed, so the run keeps handing
+ * out zero-filled memory.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena is `NULL` or points to `NULL`.
+ * - `ptr` is `NULL`.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena the memory was allocated from.
+ * @param [in] `ptr` Memory previously returned by the arena.
+ * @param [in] `old_size` Size the allocation was made with.
+ * @param [in] `new_size` Size to resize the allocation to.
+ *
+ * @return true if the allocation was resized in place, false otherwise.
+ */
+bool size_class_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size);
+
+/**
+ * @brief Size class memory allocation verification function.
+ *
+ * The size class allocator grows on demand and therefore reports that an allocation can
+ * be satisfied unless the arena has a capacity limit, the active block has no room for
+ * another run and the limit leaves no room for a new block.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - Arena is `NULL`.
+ * - Allocation size is zero.
+ *
+ * @param [in] `arena` Pointer to the arena to check for allocation possibility.
+ * @param [in] `allocation_size` Size of the potential allocation.
+ *
+ * @return true unless the capacity limit may prevent the arena from growing.
+ */
+bool __attribute__((pure)) size_class_alloc_verify(MemoryArena *const arena, const size_t allocation_size);
+
+/**
+ * @brief Copies the occupancy of every size class of an arena.
+ *
+ * @param [in] `table` Size class table of the arena.
+ * @param [out] `occupancy` Array receiving one entry per class, smallest class first.
+ * @param [in] `count` Number of entries `occupancy` can hold.
+ *
+ * @return Number of entries written.
+ */
+size_t size_class_occupancy(const SizeClassTable *const table, MemorySizeClassOccupancy *const occupancy,
+                            const size_t count);
+
+#endif    // !ANVIL_MEMORY_SIZE_CLASS_ALLOCATOR_INTERNAL_H
@@ -17,6 +17,16 @@
 #include "anvil/memory/internal/arena_internal.h"
 #include <stddef.h>
 
+/**
+ * @brief Blocks past the top an unwind keeps for the next overflow.
+ */
+#define STACK_CACHE_BLOCKS 2
+
+/**
+ * @brief Unwinds in a row the cached blocks may go unused before they are released.
+ */
+#define STACK_CACHE_DECAY  16
+
 /*****************************************************************************************************
  *					Stack Allocator
  * ***************************************************************************************************/
@@ -42,79 +52,105 @@ void stack_free(MemoryBlock *const memory_block);
  * @brief Stack memory reset strategy for memory allocator.
  *
  * This function will reset the first memory block in a memory block chain by setting
- * its allocated memory counter to zero. It will free the rest of the memory blocks and
- * set the next pointer to NULL. This returns the memory block chain to the state it was
- * at when it was first created.
+ * its allocated memory counter to zero. The rest of the memory blocks are rewound or
+ * freed according to the arena's reset policy. With the default policy this returns the
+ * memory block chain to the state it was at when it was first created.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - head memory block in the memory block chain is `NULL`.
  *
  * @param [in] `memory_block` Pointer to the head of the memory block chain to reset.
+ * @param [in,out] `policy` Reset policy deciding which of the following blocks are kept.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-void stack_reset(MemoryBlock *const memory_block);
+void stack_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
 
 /**
  * @brief Stack memory allocation strategy for memory allocator.
  *
  * This function attempts to allocate memory from the current top memory block.
  * The memory is properly aligned according to the specified alignment requirement.
- * If there is not enough space in the current block, it creates a new block with
- * doubled capacity, links it as the new top block, and updates the memory_block
- * pointer to point to this new block.
+ * If there is not enough space in the current block, it moves on to the first block past it,
+ * retained by a reset or cached by an unwind, that fits the allocation and releases the ones
+ * skipped. Without one it creates a new block sized by the arena's growth policy. The block
+ * is linked as the new top block and the memory_block pointer updated to point to it.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - memory_block pointer is `NULL` or points to `NULL`.
  * - The current block's memory is `NULL`.
  * - The alignment provided is not a power of two.
- * - The alignment is not >= the alignment of `max_align_t`.
  * - The allocation size is zero.
- * - The current block has a non-NULL next pointer (stack allocation must happen at the top).
+ * - The current block is followed by a non-empty block (stack allocation must happen at the top).
  *
  * @param [in,out] `memory_block` Pointer to the pointer of the current top memory block.
  *                               This will be updated to point to a new block if the current
  *                               block cannot satisfy the allocation.
  * @param [in] `allocation_size` Amount of memory to allocate from the memory block.
  * @param [in] `alignment` Alignment of the allocated memory.
+ * @param [in,out] `mapping` Mapping policy of the arena, used when blocks are created or released.
  *
- * @return Pointer to aligned allocated memory. Unlike scratch_alloc, this function will
- *         never return NULL as it will either allocate from the current block or create a new one.
+ * @return Pointer to aligned allocated memory, or NULL if the allocation does not fit the
+ *         current block and the capacity limit of the arena leaves no room for a new one.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
 void *__attribute__((malloc, warn_unused_result)) stack_alloc(MemoryBlock **const memory_block,
-                                                              const size_t allocation_size, const size_t alignment);
+                                                              const size_t allocation_size, const size_t alignment,
+                                                              MappingPolicy *const mapping);
+
+/**
+ * @brief Keeps the blocks past the top of an unwound stack as a cache for the next overflow.
+ *
+ * A loop that records, allocates past the end of the top block and unwinds would otherwise
+ * map and release a block on every iteration. The first `STACK_CACHE_BLOCKS` blocks past
+ * `top` stay linked, their used memory cleared as a reset clears it, and the rest are
+ * released. The cache has hysteresis: it survives any number of unwinds that reach it, and
+ * is only released once `STACK_CACHE_DECAY` unwinds in a row found it unused.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `top`, `idle_unwinds`, `policy` or `mapping` is `NULL`.
+ *
+ * @param [in,out] `top` Top block of the stack after the unwind.
+ * @param [in,out] `idle_unwinds` Unwinds in a row that found the cache unused.
+ * @param [in] `policy` Reset policy of the arena, deciding how cached blocks are cleared.
+ * @param [in,out] `mapping` Mapping policy of the arena, used when blocks are released.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void stack_cache(MemoryBlock *const top, size_t *const idle_unwinds, const ResetPolicy *const policy,
+                 MappingPolicy *const mapping);
 
 /**
  * @brief Stack memory allocation test strategy.
  *
  * This function checks if an allocation of the given size and alignment could be made
- * from the current memory block chain. For the stack allocator, this function always
- * returns true because it can dynamically allocate new blocks when needed.
- *
- * As the implementation shows, the stack allocator is designed to be dynamic and will
- * always be able to create a new memory block if the current one is insufficient. As a result,
- * this verification function always returns true, as long as the system has memory
- * available for the allocator to use.
+ * from the current memory block chain. The stack allocator creates new blocks when needed,
+ * so this only returns false when the allocation fits neither the top block nor a block past
+ * it, and the arena's capacity limit leaves no room for a block that holds it.
  *
  * The function will CRASH (not return an error) if its invariants are violated:
  * - Memory block is `NULL`.
  * - Alignment is not a power of two.
  * - Allocation size is zero.
+ * - Mapping policy is `NULL`.
  *
  * @param [in] `memory_block` The current top memory block in the stack.
  * @param [in] `allocation_size` Amount of memory to check for allocation possibility.
  * @param [in] `alignment` Alignment requirement for the potential allocation.
+ * @param [in] `mapping` Mapping policy of the arena.
  *
- * @return Always returns true for stack allocator, as it can dynamically grow by
- *         allocating new blocks when needed. If the system runs out of memory during actual
- *         allocation, an invariant failure will occur rather than returning false here.
+ * @return true unless the capacity limit prevents the arena from growing to hold the
+ *         allocation. If the system runs out of memory during actual allocation, an invariant
+ *         failure will occur rather than returning false here.
  *
  * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
  *       diagnostics rather than returning error codes.
  */
-bool stack_alloc_verify(MemoryBlock *const memory_block, const size_t allocation_size, const size_t alignment);
+bool stack_alloc_verify(MemoryBlock *const memory_block, const size_t allocation_size, const size_t alignment,
+                        const MappingPolicy *const mapping);
 #endif    // !ANVIL_MEMORY_ARENA_STACK
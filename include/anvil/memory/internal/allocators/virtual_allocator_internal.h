@@ -0,0 +1,182 @@
+/**
+ * @file virtual_allocator_internal.h
+ * @brief Internal implementation of the Virtual Memory Allocator.
+ *
+ * The Virtual allocator reserves one large range of address space when the arena is created
+ * and bump allocates from it. The range is mapped `PROT_NONE`, so it costs no memory until
+ * used, and pages are committed with `mprotect` as the allocation offset advances. The arena
+ * therefore never chains blocks: its memory is contiguous, allocations never have to skip the
+ * tail of a full block, and pointers stay valid for the lifetime of the arena. Once the
+ * reservation is exhausted allocations return `NULL`.
+ */
+
+#ifndef ANVIL_MEMORY_VIRTUAL_ALLOCATOR_INTERNAL_H
+#define ANVIL_MEMORY_VIRTUAL_ALLOCATOR_INTERNAL_H
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include <stddef.h>
+
+/**
+ * @brief Address space reserved by a VIRTUAL arena when no reservation is requested.
+ */
+#define VIRTUAL_DEFAULT_RESERVE (sizeof(void *) == 8 ? (size_t)1 << 36 : (size_t)1 << 30)
+
+/**
+ * @brief Smallest step in which a VIRTUAL arena commits memory.
+ *
+ * Committing ahead of the allocation offset keeps the number of `mprotect` calls low, and
+ * matching the huge page size lets transparent huge pages back the committed range.
+ */
+#define VIRTUAL_COMMIT_STEP ((size_t)1 << 21)
+
+/*****************************************************************************************************
+ *					Virtual Allocator
+ * ***************************************************************************************************/
+
+/**
+ * @brief Virtual memory free strategy for memory allocator.
+ *
+ * This function unmaps the whole reservation of the arena, committed or not.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ *
+ * @param [in] `memory_block` Pointer to the reserved block of the arena.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void virtual_free(MemoryBlock *const memory_block);
+
+/**
+ * @brief Virtual memory reset strategy for memory allocator.
+ *
+ * This function clears the used memory according to the arena's reset policy and rewinds
+ * the allocation offset. Committed pages stay committed, so refilling the arena up to its
+ * previous size makes no further `mprotect` calls.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ *
+ * @param [in,out] `memory_block` Pointer to the reserved block of the arena.
+ * @param [in,out] `policy` Reset policy of the arena.
+ * @param [in,out] `mapping` Mapping policy counting the blocks released.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void virtual_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping);
+
+/**
+ * @brief Commits the first `size` bytes of the reservation of a VIRTUAL arena.
+ *
+ * Pages are committed with `safe_aligned_commit`. The result is capped at the block's
+ * capacity, so the committed bytes can be compared against the allocation offset without
+ * also checking the capacity.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `memory_block` is `NULL`.
+ * - The system runs out of memory.
+ *
+ * @param [in] `memory_block` Pointer to the reserved block of the arena.
+ * @param [in] `committed` Bytes already committed.
+ * @param [in] `size` Bytes that must be committed, capped at the capacity.
+ *
+ * @return Bytes committed after the call, never more than the capacity.
+ */
+size_t virtual_commit(MemoryBlock *const memory_block, const size_t committed, const size_t size);
+
+/**
+ * @brief Virtual memory allocation strategy for memory allocator.
+ *
+ * This function bumps `allocation_size` bytes, padded to the arena alignment, out of the
+ * reservation. When the allocation reaches past the committed pages, at least
+ * `VIRTUAL_COMMIT_STEP` more bytes are committed.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - The memory_block in the arena is `NULL`.
+ * - The allocation size is zero.
+ * - The system runs out of memory while committing pages.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ *
+ * @returns Pointer to allocated memory.
+ * @returns NULL if the reservation does not have enough room left.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) virtual_alloc(MemoryArena **const arena,
+                                                                const size_t allocation_size);
+
+/**
+ * @brief Virtual memory allocation strategy with a per-allocation alignment.
+ *
+ * This function behaves like `virtual_alloc` but first advances the allocation offset to the
+ * next multiple of `alignment`. The allocation itself is still padded to the arena alignment,
+ * so later allocations stay aligned.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - The memory_block in the arena is `NULL`.
+ * - The alignment is not a power of two or smaller than the arena alignment.
+ * - The allocation size is zero.
+ * - The system runs out of memory while committing pages.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena to allocate from.
+ * @param [in] `allocation_size` Amount of memory to allocate.
+ * @param [in] `alignment` Alignment of the allocation.
+ *
+ * @returns Pointer to allocated memory.
+ * @returns NULL if the reservation does not have enough room left.
+ *
+ * @note This function follows fail-fast design - programmer errors trigger immediate crashes with
+ *       diagnostics rather than returning error codes.
+ */
+void *__attribute__((malloc, warn_unused_result)) virtual_alloc_aligned(MemoryArena **const arena,
+                                                                        const size_t allocation_size,
+                                                                        const size_t alignment);
+
+/**
+ * @brief Resizes the most recent allocation of a VIRTUAL arena in place.
+ *
+ * Both sizes are padded to the arena alignment. Growing commits more pages as needed, so the
+ * allocation can grow in place up to the end of the reservation. Shrinking keeps the pages
+ * committed.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - arena or *arena is `NULL`.
+ * - `ptr` is `NULL`.
+ * - The system runs out of memory while committing pages.
+ *
+ * @param [in,out] `arena` Pointer to the pointer of the arena the memory was allocated from.
+ * @param [in] `ptr` Memory previously returned by the arena.
+ * @param [in] `old_size` Size the allocation was made with.
+ * @param [in] `new_size` Size to resize the allocation to.
+ *
+ * @return true if the allocation was resized in place, false if it is not the most recent
+ *         allocation or the reservation does not have enough room left.
+ */
+bool virtual_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size);
+
+/**
+ * @brief Virtual memory allocation verification function.
+ *
+ * This function checks if an allocation of the given size still fits in the arena's
+ * reservation.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - Arena is `NULL`.
+ * - Allocation size is zero.
+ *
+ * @param [in] `arena` Pointer to the arena to check for allocation possibility.
+ * @param [in] `allocation_size` Size of the potential allocation.
+ *
+ * @return true if the allocation fits in the reservation, false otherwise.
+ */
+bool __attribute__((pure)) virtual_alloc_verify(MemoryArena *const arena, const size_t allocation_size);
+
+#endif    // !ANVIL_MEMORY_VIRTUAL_ALLOCATOR_INTERNAL_H
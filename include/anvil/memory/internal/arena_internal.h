@@ -12,6 +12,8 @@
 #define ANVIL_MEMORY_ARENA_INTERNAL_H
 
 #include "anvil/memory/arena.h"
+#include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -24,19 +26,31 @@
  * - allocated is less than or equal to capacity.
  * - capacity is larger than zero.
  * - memory points to a valid, aligned memory region.
+ * - every byte at or past the larger of allocated and dirty is zero.
+ * - pinned is at least the offset of every live mark, snapshot or checkpoint in the block.
  *
  * Fields      | Type                | Size
  * ----------- | ------------------- | -------------
  * memory      | void *              | 4 or 8 Bytes
  * next        | struct MemoryBlock* | 4 or 8 Bytes
  * capacity    | size_t              | 4 or 8 Bytes
+ * mapped      | size_t              | 4 or 8 Bytes
  * allocated   | size_t              | 4 or 8 Bytes
+ * dirty       | size_t              | 4 or 8 Bytes
+ * pinned      | size_t              | 4 or 8 Bytes
+ * sensitive   | bool                | 1 Byte
+ * placed      | bool                | 1 Byte
  */
 typedef struct MemoryBlock {
 	void *memory;                ///< Aligned memory pointer
 	struct MemoryBlock *next;    ///< Linked Memory Block (used by Linear allocator)
 	size_t capacity;             ///< Usable capacity
+	size_t mapped;               ///< Capacity the mapping was created with, kept when the block is reused
 	size_t allocated;            ///< Currently used bytes
+	size_t dirty;                ///< High water of the bytes rewinds left uncleared
+	size_t pinned;               ///< Offset of the latest mark, allocations below it are not resized in place
+	bool sensitive;              ///< Wipe the used bytes before the block is released
+	bool placed;                 ///< Pages carry a NUMA policy other than the default
 } MemoryBlock;
 
 /**
@@ -50,15 +64,17 @@ typedef struct MemoryBlock {
  * top         | MemoryBlock *       | 4 or 8 Bytes
  * allocated   | size_t              | 4 or 8 Bytes
  * capacity    | size_t              | 4 or 8 Bytes
+ * requested   | size_t              | 4 or 8 Bytes
  */
 typedef struct {
 	MemoryBlock *top;    ///< Pointer to the MemoryBlock that was active when the snapshot was taken.
 	size_t allocated;    ///< The number of bytes allocated in the 'top' block at the time of the snapshot.
 	size_t capacity;     ///< The capacity of the top memory block.
+	size_t requested;    ///< Bytes requested from the arena since its last reset, restored by unwind.
 } Snapshot;
 
-static_assert(sizeof(Snapshot) == 12 || sizeof(Snapshot) == 24,
-              "Snapshot must be either 8 or 16 bytes depending on architecture");
+static_assert(sizeof(Snapshot) == 16 || sizeof(Snapshot) == 32,
+              "Snapshot must be either 16 or 32 bytes depending on architecture");
 static_assert(_Alignof(Snapshot) == _Alignof(MemoryBlock *), "Snapshot alignment must match MemoryBlock* alignment");
 
 /**
@@ -82,24 +98,26 @@ static_assert(_Alignof(ScratchAllocatorState) == _Alignof(int),
               "ScratchAllocatorState alignment must match integer alignment");
 
 /**
- * @brief Placeholder state structure for the Linear Allocator.
+ * @brief State structure specifically for the Linear Allocator.
  *
- * Currently contains a dummy variable to comply with C standards requiring
- * at least one member in a struct. This may be expanded in the future if the
- * Linear allocator requires specific state tracking.
+ * Tracks the active block allocations are bumped from, so the common allocation only
+ * touches that block instead of walking the chain from its head. Blocks before the
+ * cursor are only revisited when the arena was created in best-fit mode.
  *
- * Fields                                  | Type | Size
- * --------------------------------------- | ---- | ---------
- * _dummy_variable_to_comply_with_standards| int  | 4 Bytes
+ * Fields   | Type         | Size
+ * -------- | ------------ | -------------
+ * cursor   | MemoryBlock* | 4 or 8 Bytes
+ * best_fit | bool         | 1 Byte
  */
 typedef struct {
-	int _dummy_variable_to_comply_with_standards;    ///< Placeholder field.
+	MemoryBlock *cursor;    ///< Active block that allocations are bumped from.
+	bool best_fit;          ///< Search earlier blocks for the tightest fit before growing.
 } LinearAllocatorState;
 
-static_assert(sizeof(LinearAllocatorState) == 4 || sizeof(LinearAllocatorState) == 8,
-              "LinearAllocatorState must be either 4 or 8 bytes depending on architecture");
-static_assert(_Alignof(LinearAllocatorState) == _Alignof(int),
-              "LinearAllocatorState alignment must match integer alignment");
+static_assert(sizeof(LinearAllocatorState) == 8 || sizeof(LinearAllocatorState) == 16,
+              "LinearAllocatorState must be either 8 or 16 bytes depending on architecture");
+static_assert(_Alignof(LinearAllocatorState) == _Alignof(MemoryBlock *),
+              "LinearAllocatorState alignment must match MemoryBlock* alignment");
 
 /**
  * @brief State structure specifically for the Stack Allocator.
@@ -113,54 +131,256 @@ static_assert(_Alignof(LinearAllocatorState) == _Alignof(int),
  * snapshots      | Snapshot*      | 4 or 8 Bytes
  * top            | MemoryBlock*   | 4 or 8 Bytes
  * snapshot_count | size_t         | 4 or 8 Bytes
+ * max_size       | size_t         | 4 or 8 Bytes
+ * cache_idle     | size_t         | 4 or 8 Bytes
  */
 typedef struct {
 	Snapshot *snapshots;      ///< Pointer to an array or linked list of saved Snapshots.
 	MemoryBlock *top;         ///< Pointer to the current MemoryBlock being used for allocations.
 	size_t snapshot_count;    ///< records the size of the snapshots array.
 	size_t max_size;          ///< maximum size before resizing the snapshot list.
+	size_t cache_idle;        ///< Unwinds in a row that found the blocks cached past the top unused.
 } StackAllocatorState;
 
-static_assert(sizeof(StackAllocatorState) == 16 || sizeof(StackAllocatorState) == 32,
-              "StackAllocatorState must be either 16 or 32 bytes depending on architecture");
+static_assert(sizeof(StackAllocatorState) == 20 || sizeof(StackAllocatorState) == 40,
+              "StackAllocatorState must be either 20 or 40 bytes depending on architecture");
 static_assert(_Alignof(StackAllocatorState) == _Alignof(MemoryBlock *),
               "StackAllocatorState alignment must match MemoryBlock* alignment");
 
+/**
+ * @brief State structure specifically for the Pool Allocator.
+ *
+ * Holds the slot size of the pool, the head of the intrusive list of freed slots and
+ * the active block that new slots are carved from.
+ *
+ * Fields    | Type         | Size
+ * --------- | ------------ | -------------
+ * slot_size | size_t       | 4 or 8 Bytes
+ * free_list | void*        | 4 or 8 Bytes
+ * cursor    | MemoryBlock* | 4 or 8 Bytes
+ */
 typedef struct {
-	size_t pool_size;
+	size_t slot_size;       ///< Size of every slot, a multiple of the arena alignment.
+	void *free_list;        ///< Most recently freed slot, linked through its first word.
+	MemoryBlock *cursor;    ///< Active block that new slots are carved from.
 } PoolAllocatorState;
 
-static_assert(sizeof(PoolAllocatorState) == 4 || sizeof(PoolAllocatorState) == 8,
-              "PoolAllocatorState must be either 4 or 8 bytes depending on architecture");
+static_assert(sizeof(PoolAllocatorState) == 12 || sizeof(PoolAllocatorState) == 24,
+              "PoolAllocatorState must be either 12 or 24 bytes depending on architecture");
 static_assert(_Alignof(PoolAllocatorState) == _Alignof(size_t),
               "PoolAllocatorState alignment must match size_t alignment");
 
+/**
+ * @brief State structure specifically for the Concurrent Allocator.
+ *
+ * Tracks the MemoryBlock that threads currently claim space from and the spin lock that
+ * serializes block growth. Both fields are only accessed through atomic builtins.
+ *
+ * Fields      | Type           | Size
+ * ----------- | -------------- | -------------
+ * current     | MemoryBlock*   | 4 or 8 Bytes
+ * growth_lock | bool           | 1 Byte
+ */
+typedef struct {
+	MemoryBlock *current;    ///< Block that allocations are claimed from.
+	bool growth_lock;        ///< Held while a thread moves on to a new block.
+} ConcurrentAllocatorState;
+
+static_assert(sizeof(ConcurrentAllocatorState) == 8 || sizeof(ConcurrentAllocatorState) == 16,
+              "ConcurrentAllocatorState must be either 8 or 16 bytes depending on architecture");
+static_assert(_Alignof(ConcurrentAllocatorState) == _Alignof(MemoryBlock *),
+              "ConcurrentAllocatorState alignment must match MemoryBlock* alignment");
+
+/**
+ * @brief State structure specifically for the Size Class Allocator.
+ *
+ * The per class bookkeeping is too large to live inside the arena, so it is kept in a heap
+ * allocated table owned by the arena. The cursor is the active block runs are carved from.
+ *
+ * Fields | Type            | Size
+ * ------ | --------------- | -------------
+ * table  | SizeClassTable* | 4 or 8 Bytes
+ * cursor | MemoryBlock*    | 4 or 8 Bytes
+ */
+typedef struct {
+	struct SizeClassTable *table;    ///< Free lists, runs and counters of every size class.
+	MemoryBlock *cursor;             ///< Active block that runs are carved from.
+} SizeClassAllocatorState;
+
+static_assert(sizeof(SizeClassAllocatorState) == 8 || sizeof(SizeClassAllocatorState) == 16,
+              "SizeClassAllocatorState must be either 8 or 16 bytes depending on architecture");
+static_assert(_Alignof(SizeClassAllocatorState) == _Alignof(MemoryBlock *),
+              "SizeClassAllocatorState alignment must match MemoryBlock* alignment");
+
+/**
+ * @brief State structure specifically for the Virtual Allocator.
+ *
+ * The arena's single block spans the whole reservation, its `capacity` being the reserved
+ * size. Only the first `committed` bytes of it are accessible, and `committed` never exceeds
+ * the capacity, so an allocation ending within it always fits.
+ *
+ * Fields    | Type   | Size
+ * --------- | ------ | -------------
+ * committed | size_t | 4 or 8 Bytes
+ */
+typedef struct {
+	size_t committed;    ///< Bytes from the start of the block's memory that are committed.
+} VirtualAllocatorState;
+
+static_assert(sizeof(VirtualAllocatorState) == 4 || sizeof(VirtualAllocatorState) == 8,
+              "VirtualAllocatorState must be either 4 or 8 bytes depending on architecture");
+static_assert(_Alignof(VirtualAllocatorState) == _Alignof(size_t),
+              "VirtualAllocatorState alignment must match size_t alignment");
+
 /**
  * @brief A union holding the state specific to the chosen allocator type.
  *
  * Depending on the `allocator_type` field in the `MemoryArena` struct,
  * the appropriate member of this union will contain the relevant state
- * information for that allocator strategy (Scratch, Linear, or Stack).
+ * information for that allocator strategy (Scratch, Linear, Stack, Pool, Concurrent, Size
+ * Class or Virtual).
  *
- * Fields                 | Type                  | Size
- * ---------------------- | --------------------- | -------------
- * scratchAllocatorState  | ScratchAllocatorState | 4 or 8 Bytes
- * linearAllocatorState   | LinearAllocatorState  | 4 or 8 Bytes
- * poolAllocatorState     | PoolAllocatorState    | 4 or 8 Bytes
- * stackAllocatorState    | StackAllocatorState   | 8 or 16 Bytes
+ * Fields                    | Type                     | Size
+ * ------------------------- | ------------------------ | -------------
+ * scratchAllocatorState     | ScratchAllocatorState    | 4 or 8 Bytes
+ * linearAllocatorState      | LinearAllocatorState     | 8 or 16 Bytes
+ * poolAllocatorState        | PoolAllocatorState       | 12 or 24 Bytes
+ * stackAllocatorState       | StackAllocatorState      | 20 or 40 Bytes
+ * concurrentAllocatorState  | ConcurrentAllocatorState | 8 or 16 Bytes
+ * sizeClassAllocatorState   | SizeClassAllocatorState  | 8 or 16 Bytes
+ * virtualAllocatorState     | VirtualAllocatorState    | 4 or 8 Bytes
  */
 typedef union {
-	ScratchAllocatorState scratchAllocatorState;    ///< State for the Scratch allocator.
-	LinearAllocatorState linearAllocatorState;      ///< State for the Linear allocator.
-	PoolAllocatorState poolAllocatorState;          ///< State for the Pool alllocator.
-	StackAllocatorState stackAllocatorState;        ///< State for the Stack allocator.
+	ScratchAllocatorState scratchAllocatorState;          ///< State for the Scratch allocator.
+	LinearAllocatorState linearAllocatorState;            ///< State for the Linear allocator.
+	PoolAllocatorState poolAllocatorState;                ///< State for the Pool alllocator.
+	StackAllocatorState stackAllocatorState;              ///< State for the Stack allocator.
+	ConcurrentAllocatorState concurrentAllocatorState;    ///< State for the Concurrent allocator.
+	SizeClassAllocatorState sizeClassAllocatorState;      ///< State for the Size Class allocator.
+	VirtualAllocatorState virtualAllocatorState;          ///< State for the Virtual allocator.
 } AllocatorState;
 
-static_assert(sizeof(AllocatorState) == 16 || sizeof(AllocatorState) == 32,
-              "AllocatorState must be either 16 or 32 bytes depending on architecture");
+static_assert(sizeof(AllocatorState) == 20 || sizeof(AllocatorState) == 40,
+              "AllocatorState must be either 20 or 40 bytes depending on architecture");
 static_assert(_Alignof(AllocatorState) == _Alignof(StackAllocatorState),
               "AllocatorState alignment must match its largest member alignment (StackAllocatorState)");
 
+/**
+ * @brief Describes what happens to an arena's block chain on reset.
+ *
+ * Holds the block retention limits and the zeroing policy taken from `MemoryArenaOptions`
+ * together with the bookkeeping needed to let retained blocks decay when they go unused.
+ *
+ * Fields            | Type               | Size
+ * ----------------- | ------------------ | -------------
+ * max_blocks        | size_t             | 4 or 8 Bytes
+ * max_bytes         | size_t             | 4 or 8 Bytes
+ * decay             | size_t             | 4 or 8 Bytes
+ * idle_resets       | size_t             | 4 or 8 Bytes
+ * release_threshold | size_t             | 4 or 8 Bytes
+ * zeroing           | MemoryResetZeroing | 4 Bytes
+ */
+typedef struct {
+	size_t max_blocks;             ///< Blocks beyond the head kept across reset.
+	size_t max_bytes;              ///< Capacity budget for retained blocks, 0 for no budget.
+	size_t decay;                  ///< Idle resets before the last retained block is released, 0 for never.
+	size_t idle_resets;            ///< Consecutive resets the last retained block has gone unused.
+	size_t release_threshold;      ///< Smallest used range released rather than zeroed.
+	MemoryResetZeroing zeroing;    ///< How the used memory of kept blocks is cleared.
+} ResetPolicy;
+
+static_assert(sizeof(ResetPolicy) == 24 || sizeof(ResetPolicy) == 48,
+              "ResetPolicy must be either 24 or 48 bytes depending on architecture");
+static_assert(_Alignof(ResetPolicy) == _Alignof(size_t), "ResetPolicy alignment must match size_t alignment");
+
+/**
+ * @brief Describes how the memory of an arena's blocks is mapped.
+ *
+ * Passed to every block creation of the arena. The page backing is lowered to the backing
+ * of each block created, so it ends up as the weakest backing of any block the arena used.
+ * Block creation also counts the blocks of the arena and where they came from, for
+ * `memory_arena_get_stats`, and places every block according to the NUMA fields. Growing
+ * allocators size new blocks with the growth fields through `memory_block_next_capacity`.
+ * Allocations above the large threshold get a block of their own through
+ * `memory_block_alloc_large`. With a spare, block creation first takes the prefaulted block
+ * the refill thread keeps ready, see block_spare_internal.h.
+ *
+ * Fields          | Type              | Size
+ * --------------- | ----------------- | -------------
+ * page_backing    | MemoryPageBacking | 4 Bytes
+ * numa_policy     | MemoryNumaPolicy  | 4 Bytes
+ * huge_pages      | bool              | 1 Byte
+ * sensitive       | bool              | 1 Byte
+ * prefault        | bool              | 1 Byte
+ * blocks          | size_t            | 4 or 8 Bytes
+ * capacity        | size_t            | 4 or 8 Bytes
+ * maps            | size_t            | 4 or 8 Bytes
+ * reuses          | size_t            | 4 or 8 Bytes
+ * releases        | size_t            | 4 or 8 Bytes
+ * unmaps          | size_t            | 4 or 8 Bytes
+ * growth_factor   | size_t            | 4 or 8 Bytes
+ * growth_chunk    | size_t            | 4 or 8 Bytes
+ * max_block       | size_t            | 4 or 8 Bytes
+ * limit           | size_t            | 4 or 8 Bytes
+ * large_threshold | size_t            | 4 or 8 Bytes
+ * numa_node       | size_t            | 4 or 8 Bytes
+ * spare           | BlockSpare *      | 4 or 8 Bytes
+ */
+typedef struct {
+	MemoryPageBacking page_backing;    ///< Weakest page backing obtained for a block.
+	MemoryNumaPolicy numa_policy;      ///< NUMA placement applied to every block.
+	bool huge_pages;                   ///< Map blocks with 2 MiB pages.
+	bool sensitive;                    ///< Blocks hold sensitive data and are wiped on release.
+	bool prefault;                     ///< Fault in the pages of every block when it is created.
+	size_t blocks;                     ///< Blocks in the arena's chain.
+	size_t capacity;                   ///< Combined capacity of those blocks.
+	size_t maps;                       ///< Blocks created with a fresh mapping.
+	size_t reuses;                     ///< Blocks taken from the block recycler.
+	size_t releases;                   ///< Blocks released before the arena was destroyed.
+	size_t unmaps;                     ///< Released blocks unmapped rather than recycled.
+	size_t growth_factor;              ///< Multiplier applied to the capacity of the last block.
+	size_t growth_chunk;               ///< Capacity of every new block, 0 to grow geometrically.
+	size_t max_block;                  ///< Largest capacity of a new block, 0 for no limit.
+	size_t limit;                      ///< Largest combined capacity of the blocks, 0 for no limit.
+	size_t large_threshold;            ///< Allocations larger than this get a block of their own, 0 for never.
+	size_t numa_node;                  ///< Node blocks are bound to with `MEMORY_NUMA_BIND`.
+	struct BlockSpare *spare;          ///< Spare block kept ready for the next creation, NULL for none.
+} MappingPolicy;
+
+static_assert(sizeof(MappingPolicy) == 64 || sizeof(MappingPolicy) == 120,
+              "MappingPolicy must be either 64 or 120 bytes depending on architecture");
+static_assert(_Alignof(MappingPolicy) == _Alignof(size_t), "MappingPolicy alignment must match size_t alignment");
+
+/**
+ * @brief Selects whether allocations update the statistics of their arena.
+ *
+ * Counting allocations adds a few instructions to every allocation, so it can be compiled
+ * out by defining `ANVIL_MEMORY_STATS` to 0. The block counters of `MappingPolicy` are only
+ * updated when blocks are created or released and are always maintained.
+ */
+#ifndef ANVIL_MEMORY_STATS
+#define ANVIL_MEMORY_STATS 1
+#endif
+
+/**
+ * @brief Allocation statistics of an arena.
+ *
+ * Fields      | Type   | Size
+ * ----------- | ------ | -------------
+ * allocations | size_t | 4 or 8 Bytes
+ * requested   | size_t | 4 or 8 Bytes
+ * high_water  | size_t | 4 or 8 Bytes
+ */
+typedef struct {
+	size_t allocations;    ///< Successful allocations since the arena was created.
+	size_t requested;      ///< Bytes requested by allocations since the last reset.
+	size_t high_water;     ///< Most bytes used seen at a reset, an unwind or a statistics query.
+} ArenaStatistics;
+
+static_assert(sizeof(ArenaStatistics) == 12 || sizeof(ArenaStatistics) == 24,
+              "ArenaStatistics must be either 12 or 24 bytes depending on architecture");
+static_assert(_Alignof(ArenaStatistics) == _Alignof(size_t), "ArenaStatistics alignment must match size_t alignment");
+
 /**
  * @brief Represents a memory arena for managing allocations.
  *
@@ -172,28 +392,69 @@ static_assert(_Alignof(AllocatorState) == _Alignof(StackAllocatorState),
  * Invariants:
  * - alignment is a power of two.
  * - memory_block points to the head of a valid (potentially single-element) MemoryBlock chain.
- * - allocator_type corresponds to a valid allocation strategy (SCRATCH, LINEAR, STACK).
+ * - allocator_type corresponds to a valid allocation strategy (SCRATCH, LINEAR, STACK, POOL, CONCURRENT,
+ *   SIZE_CLASS, VIRTUAL).
  *
  * Fields           | Type              | Size
  * ---------------- | ----------------- | -------------
  * allocator_type   | AllocatorType     | 4 or 8 Bytes
  * memory_block     | MemoryBlock *     | 4 or 8 Bytes
+ * large_blocks     | MemoryBlock *     | 4 or 8 Bytes
  * alignment        | size_t            | 4 or 8 Bytes
- * state            | AllocatorState    | 8 or 16 bytes
+ * state            | AllocatorState    | 20 or 40 bytes
+ * reset_policy     | ResetPolicy       | 24 or 48 bytes
+ * mapping_policy   | MappingPolicy     | 64 or 120 bytes
+ * stats            | ArenaStatistics   | 12 or 24 bytes
+ * registry_prev    | MemoryArena *     | 4 or 8 Bytes
+ * registry_next    | MemoryArena *     | 4 or 8 Bytes
  *
- * @note Memory Arenas created using this structure are **NOT** thread-safe.
- * External synchronization is required if used in concurrent environments.
+ * @note Memory Arenas created using this structure are **NOT** thread-safe, with the exception
+ * of allocations from CONCURRENT arenas. External synchronization is required otherwise.
  */
 typedef struct memory_arena_t {
-	AllocatorType allocator_type;    ///< Strategy used for allocation (SCRATCH, LINEAR, STACK).
-	MemoryBlock *memory_block;       ///< Pointer to the underlying memory block(s).
-	size_t alignment;                ///< Alignment requirement for all allocations.
-	AllocatorState state;            ///< Allocator specific state.
+	AllocatorType allocator_type;            ///< Strategy used for allocation.
+	MemoryBlock *memory_block;               ///< Pointer to the underlying memory block(s).
+	MemoryBlock *large_blocks;               ///< Blocks holding a single large allocation each.
+	size_t alignment;                        ///< Alignment requirement for all allocations.
+	AllocatorState state;                    ///< Allocator specific state.
+	ResetPolicy reset_policy;                ///< Block retention applied by reset.
+	MappingPolicy mapping_policy;            ///< Page backing requested and obtained for blocks.
+	ArenaStatistics stats;                   ///< Allocation statistics.
+	struct memory_arena_t *registry_prev;    ///< Previous arena in the registry of live arenas.
+	struct memory_arena_t *registry_next;    ///< Next arena in the registry of live arenas.
 } MemoryArena;
 
-static_assert(sizeof(MemoryArena) == 28 || sizeof(MemoryArena) == 56,
-              "MemoryArena must be either 28 or 56 bytes depending on architecture");
+static_assert(sizeof(MemoryArena) == 144 || sizeof(MemoryArena) == 280,
+              "MemoryArena must be either 144 or 280 bytes depending on architecture");
 static_assert(_Alignof(MemoryArena) == _Alignof(MemoryBlock *),
               "Alignment of MemoryArena must match the alignment of a pointer");
 
+/**
+ * @brief Counts `count` successful allocations of `bytes` bytes in total.
+ *
+ * Compiles to nothing when `ANVIL_MEMORY_STATS` is 0. The counters of CONCURRENT arenas are
+ * updated with atomic additions, other arenas are only written by their owner and use plain
+ * relaxed stores so a concurrent `memory_arena_get_global_stats` reads whole values.
+ *
+ * @param[in,out] `arena` Arena the allocations were made from.
+ * @param[in] `count` Number of allocations.
+ * @param[in] `bytes` Bytes requested by those allocations.
+ */
+static inline __attribute__((always_inline)) void memory_arena_count(MemoryArena *const arena, const size_t count,
+                                                                     const size_t bytes) {
+#if ANVIL_MEMORY_STATS
+	if (arena->allocator_type == CONCURRENT) {
+		__atomic_fetch_add(&arena->stats.allocations, count, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&arena->stats.requested, bytes, __ATOMIC_RELAXED);
+		return;
+	}
+	__atomic_store_n(&arena->stats.allocations, arena->stats.allocations + count, __ATOMIC_RELAXED);
+	__atomic_store_n(&arena->stats.requested, arena->stats.requested + bytes, __ATOMIC_RELAXED);
+#else
+	(void)arena;
+	(void)count;
+	(void)bytes;
+#endif
+}
+
 #endif    // ANVIL_MEMORY_ARENA_INTERNAL_H
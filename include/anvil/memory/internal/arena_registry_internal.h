@@ -0,0 +1,54 @@
+/**
+ * @file arena_registry_internal.h
+ * @brief Internal process-wide registry of live arenas.
+ *
+ * Every arena is linked into a single list when it is created and unlinked when it is
+ * destroyed, so the statistics of all live arenas can be summed without the caller knowing
+ * which arenas exist. The links live in the arena itself, so registering an arena costs no
+ * allocation. The list is guarded by a mutex that is only taken when an arena is created or
+ * destroyed and when the statistics are collected, never on an allocation.
+ */
+
+#ifndef ANVIL_MEMORY_ARENA_REGISTRY_INTERNAL_H
+#define ANVIL_MEMORY_ARENA_REGISTRY_INTERNAL_H
+
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/arena_internal.h"
+
+/**
+ * @brief Links an arena into the registry.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `arena` is `NULL`.
+ *
+ * @param[in,out] `arena` Newly created arena.
+ */
+void arena_registry_add(MemoryArena *const arena);
+
+/**
+ * @brief Unlinks an arena from the registry.
+ *
+ * Must be called before the arena's memory is released, so a concurrent collection never
+ * reads a destroyed arena.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `arena` is `NULL`.
+ *
+ * @param[in,out] `arena` Arena about to be destroyed.
+ */
+void arena_registry_remove(MemoryArena *const arena);
+
+/**
+ * @brief Sums the statistics of every registered arena.
+ *
+ * Counters are read with relaxed atomic loads while the registry is locked. `mmap_calls` and
+ * `munmap_calls` are left for the caller to fill in.
+ *
+ * The function will CRASH (not return an error) if its invariants are violated:
+ * - `stats` is `NULL`.
+ *
+ * @param[out] `stats` Receives the summed statistics.
+ */
+void arena_registry_collect(MemoryGlobalStats *const stats);
+
+#endif    // !ANVIL_MEMORY_ARENA_REGISTRY_INTERNAL_H
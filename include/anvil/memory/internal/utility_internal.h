@@ -59,6 +59,57 @@
 		}                                                                                                      \
 	} while (0)
 
+/**
+ * @brief Check levels selectable with `ANVIL_MEMORY_CHECK_LEVEL`.
+ *
+ * Level    | INVARIANT | HOT_INVARIANT | PARANOID_INVARIANT
+ * -------- | --------- | ------------- | ------------------
+ * FAST     | checked   | compiled out  | compiled out
+ * DEFAULT  | checked   | checked       | compiled out
+ * PARANOID | checked   | checked       | checked
+ */
+#define ANVIL_MEMORY_CHECK_FAST     0
+#define ANVIL_MEMORY_CHECK_DEFAULT  1
+#define ANVIL_MEMORY_CHECK_PARANOID 2
+
+#ifndef ANVIL_MEMORY_CHECK_LEVEL
+#define ANVIL_MEMORY_CHECK_LEVEL ANVIL_MEMORY_CHECK_DEFAULT
+#endif
+
+/**
+ * @brief Assert an invariant on the arguments of a hot path call.
+ *
+ * Used for checks repeated on every allocation or free, such as a `NULL` arena or a zero
+ * size. Behaves like `INVARIANT` unless the library is built with the FAST check level, in
+ * which case the expression is not evaluated.
+ *
+ * @param expr The expression that must be true.
+ * @param fmt Format string for the error message.
+ * @param ... Arguments for the format string.
+ */
+#if ANVIL_MEMORY_CHECK_LEVEL >= ANVIL_MEMORY_CHECK_DEFAULT
+#define HOT_INVARIANT(expr, fmt, ...) INVARIANT(expr, fmt, ##__VA_ARGS__)
+#else
+#define HOT_INVARIANT(expr, fmt, ...) ((void)sizeof(!(expr)))
+#endif
+
+/**
+ * @brief Assert an invariant on arena state that can not change after creation.
+ *
+ * Used on hot paths to re-validate state that was already checked when the arena was
+ * created, such as the alignment being a power of two. Only evaluated when the library is
+ * built with the PARANOID check level.
+ *
+ * @param expr The expression that must be true.
+ * @param fmt Format string for the error message.
+ * @param ... Arguments for the format string.
+ */
+#if ANVIL_MEMORY_CHECK_LEVEL >= ANVIL_MEMORY_CHECK_PARANOID
+#define PARANOID_INVARIANT(expr, fmt, ...) INVARIANT(expr, fmt, ##__VA_ARGS__)
+#else
+#define PARANOID_INVARIANT(expr, fmt, ...) ((void)sizeof(!(expr)))
+#endif
+
 #ifdef DEBUG
 /**
  * @brief Debug version of mmap that poisons allocated memory.
@@ -1,10 +1,16 @@
 #include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/block_spare_internal.h"
 #include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/allocators/concurrent_allocator_internal.h"
 #include "anvil/memory/internal/allocators/linear_allocator_internal.h"
 #include "anvil/memory/internal/allocators/pool_allocator_internal.h"
 #include "anvil/memory/internal/allocators/scratch_allocator_internal.h"
+#include "anvil/memory/internal/allocators/size_class_allocator_internal.h"
 #include "anvil/memory/internal/allocators/stack_allocator_internal.h"
+#include "anvil/memory/internal/allocators/virtual_allocator_internal.h"
 #include "anvil/memory/internal/arena_internal.h"
+#include "anvil/memory/internal/arena_registry_internal.h"
 #include "anvil/memory/internal/error/error_templates.h"
 #include "anvil/memory/internal/utility_internal.h"
 #include <assert.h>
@@ -29,6 +35,12 @@ const char *get_allocator_type_name(AllocatorType type) {
 			return "STACK";
 		case POOL:
 			return "POOL";
+		case CONCURRENT:
+			return "CONCURRENT";
+		case SIZE_CLASS:
+			return "SIZE_CLASS";
+		case VIRTUAL:
+			return "VIRTUAL";
 		case COUNT:
 			return "COUNT";
 		default:
@@ -37,26 +49,107 @@ const char *get_allocator_type_name(AllocatorType type) {
 }
 
 MemoryArena *memory_arena_create(const AllocatorType type, const size_t alignment, const size_t initial_size) {
+	return memory_arena_create_with_options(type, alignment, initial_size, NULL);
+}
+
+MemoryArena *memory_arena_create_with_options(const AllocatorType type, const size_t alignment,
+                                              const size_t initial_size, const MemoryArenaOptions *const options) {
 	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
 	INVARIANT(type != COUNT, ERR_INVALID_ALLOCATOR_TYPE, COUNT, type);
 	INVARIANT(initial_size != 0, ERR_ZERO_CAPACITY, initial_size);
 
-	MemoryArena *arena = malloc(sizeof(*arena));
-	INVARIANT(arena != NULL, ERR_OUT_OF_MEMORY, sizeof(*arena));
-
-	arena->memory_block = malloc(sizeof(*arena->memory_block));
-	INVARIANT(arena->memory_block != NULL, ERR_OUT_OF_MEMORY, sizeof(*arena->memory_block));
+	const MemoryArenaOptions defaults = {0};
+	const MemoryArenaOptions *const settings = options ? options : &defaults;
+	MappingPolicy mapping_policy = {
+	    .page_backing = settings->huge_pages ? MEMORY_PAGES_HUGETLB : MEMORY_PAGES_DEFAULT,
+	    .huge_pages = settings->huge_pages,
+	    .sensitive = settings->sensitive,
+	    .prefault = settings->prefault,
+	    .growth_factor = settings->growth_factor,
+	    .growth_chunk = settings->growth_chunk,
+	    .max_block = settings->max_block_size,
+	    .limit = settings->capacity_limit,
+	    .large_threshold = settings->large_threshold,
+	    .numa_policy = settings->numa_policy,
+	    .numa_node = settings->numa_node,
+	};
+
+	INVARIANT(settings->reset_zeroing <= MEMORY_RESET_ZERO_RELEASE, ERR_LESS_EQUAL, "reset_zeroing",
+	          "MEMORY_RESET_ZERO_RELEASE", (size_t)settings->reset_zeroing, (size_t)MEMORY_RESET_ZERO_RELEASE);
+	INVARIANT(settings->numa_policy <= MEMORY_NUMA_INTERLEAVE, ERR_LESS_EQUAL, "numa_policy",
+	          "MEMORY_NUMA_INTERLEAVE", (size_t)settings->numa_policy, (size_t)MEMORY_NUMA_INTERLEAVE);
+	INVARIANT(settings->numa_policy != MEMORY_NUMA_BIND || safe_numa_node_allowed(settings->numa_node),
+	          ERR_INVALID_STATE, "numa_node", "allowed node", "unavailable node");
+
+	// The head block counts against the capacity limit with the capacity it is mapped with.
+	const size_t limit = settings->capacity_limit ? settings->capacity_limit : SIZE_MAX;
+	MemoryBlock *head;
+	if (type == SIZE_CLASS) {
+		INVARIANT(initial_size <= SIZE_MAX - SIZE_CLASS_RUN_SIZE, ERR_LESS_EQUAL, "capacity",
+		          "SIZE_MAX - SIZE_CLASS_RUN_SIZE", initial_size, SIZE_MAX - SIZE_CLASS_RUN_SIZE);
+		const size_t capacity = (initial_size + (SIZE_CLASS_RUN_SIZE - 1)) & ~(SIZE_CLASS_RUN_SIZE - 1);
+		const size_t mapped = memory_block_mapped_capacity(&mapping_policy, capacity, SIZE_CLASS_RUN_SIZE);
+		INVARIANT(mapped <= limit, ERR_LESS_EQUAL, "capacity", "capacity_limit", mapped, limit);
+		head = memory_block_create(capacity, SIZE_CLASS_RUN_SIZE, &mapping_policy);
+	} else if (type == VIRTUAL) {
+		// The whole reservation counts against the limit, so by default it is capped there.
+		size_t reserve = settings->virtual_reserve;
+		if (reserve == 0) {
+			reserve = limit < VIRTUAL_DEFAULT_RESERVE ? limit & ~(alignment - 1) : VIRTUAL_DEFAULT_RESERVE;
+			reserve = initial_size > reserve ? initial_size : reserve;
+		}
+		INVARIANT(initial_size <= reserve, ERR_LESS_EQUAL, "capacity", "virtual_reserve", initial_size,
+		          reserve);
+		INVARIANT(reserve <= SIZE_MAX - (alignment - 1), ERR_LESS_EQUAL, "virtual_reserve",
+		          "SIZE_MAX - alignment", reserve, SIZE_MAX - (alignment - 1));
+		const size_t capacity = (reserve + (alignment - 1)) & ~(alignment - 1);
+		INVARIANT(capacity <= limit, ERR_LESS_EQUAL, "virtual_reserve", "capacity_limit", capacity, limit);
+		head = memory_block_reserve(capacity, alignment, &mapping_policy);
+	} else {
+		INVARIANT(initial_size <= SIZE_MAX - (alignment - 1), ERR_LESS_EQUAL, "capacity", "SIZE_MAX - alignment",
+		          initial_size, SIZE_MAX - (alignment - 1));
+		const size_t capacity = (initial_size + (alignment - 1)) & ~(alignment - 1);
+		const size_t mapped = memory_block_mapped_capacity(&mapping_policy, capacity, alignment);
+		INVARIANT(mapped <= limit, ERR_LESS_EQUAL, "capacity", "capacity_limit", mapped, limit);
+		head = memory_block_create(capacity, alignment, &mapping_policy);
+	}
 
-	arena->memory_block->capacity = (initial_size + (alignment - 1)) & ~(alignment - 1);
-	arena->memory_block->allocated = 0;
-	arena->memory_block->next = NULL;
+	/*
+	 * NOTE: The arena lives in the header of its head block, so creating an arena maps a single
+	 * region and performs no heap allocation of its own.
+	 */
+	MemoryArena *arena = memory_block_arena(head);
+	arena->memory_block = head;
+	arena->large_blocks = NULL;
+	arena->mapping_policy = mapping_policy;
 	arena->alignment = alignment;
+
+	// Only growing arenas create blocks after the head, the refill thread prepares the next one.
+	if (settings->spare_block && type != SCRATCH && type != VIRTUAL) {
+		const size_t block_alignment = type == SIZE_CLASS ? SIZE_CLASS_RUN_SIZE : alignment;
+		arena->mapping_policy.spare = block_spare_create(&arena->mapping_policy, block_alignment);
+		const size_t next = memory_block_next_capacity(&arena->mapping_policy, head->capacity, 1, block_alignment);
+		if (next != 0) {
+			block_spare_refill(arena->mapping_policy.spare, next);
+		}
+	}
 	arena->allocator_type = type;
+	arena->stats = (ArenaStatistics){0};
+
+	arena->reset_policy = (ResetPolicy){
+	    .max_blocks = settings->retain_blocks,
+	    .max_bytes = settings->retain_bytes,
+	    .decay = settings->retain_decay,
+	    .idle_resets = 0,
+	    .release_threshold =
+	        settings->reset_release_threshold ? settings->reset_release_threshold : RESET_RELEASE_DEFAULT_THRESHOLD,
+	    .zeroing = settings->sensitive ? MEMORY_RESET_ZERO_EAGER : settings->reset_zeroing,
+	};
 
 	switch (arena->allocator_type) {
 		case LINEAR:
 			arena->state.linearAllocatorState =
-			    (LinearAllocatorState){._dummy_variable_to_comply_with_standards = 0};
+			    (LinearAllocatorState){.cursor = arena->memory_block, .best_fit = settings->best_fit};
 			break;
 		case SCRATCH:
 			arena->state.scratchAllocatorState =
@@ -66,14 +159,37 @@ MemoryArena *memory_arena_create(const AllocatorType type, const size_t alignmen
 			arena->state.stackAllocatorState.top = arena->memory_block;
 			arena->state.stackAllocatorState.max_size = INITIAL_STACK_SNAPSHOT_SIZE;
 			arena->state.stackAllocatorState.snapshot_count = 0;
+			arena->state.stackAllocatorState.cache_idle = 0;
 			arena->state.stackAllocatorState.top->next = NULL;
 			arena->state.stackAllocatorState.snapshots =
 			    malloc(INITIAL_STACK_SNAPSHOT_SIZE * sizeof(Snapshot));
 			INVARIANT(arena->state.stackAllocatorState.snapshots, ERR_OUT_OF_MEMORY,
 			          INITIAL_STACK_SNAPSHOT_SIZE * sizeof(Snapshot));
 			break;
-		case POOL:
-			arena->state.poolAllocatorState = (PoolAllocatorState){.pool_size = initial_size};
+		case POOL: {
+			const size_t slot_size = settings->pool_slot_size ? settings->pool_slot_size : initial_size;
+			INVARIANT(slot_size <= SIZE_MAX - (alignment - 1), ERR_LESS_EQUAL, "pool_slot_size",
+			          "SIZE_MAX - alignment", slot_size, SIZE_MAX - (alignment - 1));
+			// Free slots are linked through their first word, so a slot holds at least a pointer.
+			const size_t aligned_slot_size = (slot_size + (alignment - 1)) & ~(alignment - 1);
+			arena->state.poolAllocatorState = (PoolAllocatorState){
+			    .slot_size = aligned_slot_size < sizeof(void *) ? sizeof(void *) : aligned_slot_size,
+			    .free_list = NULL,
+			    .cursor = arena->memory_block,
+			};
+			break;
+		}
+		case CONCURRENT:
+			arena->state.concurrentAllocatorState =
+			    (ConcurrentAllocatorState){.current = arena->memory_block, .growth_lock = false};
+			break;
+		case SIZE_CLASS:
+			arena->state.sizeClassAllocatorState = (SizeClassAllocatorState){
+			    .table = size_class_table_create(alignment), .cursor = arena->memory_block};
+			break;
+		case VIRTUAL:
+			arena->state.virtualAllocatorState = (VirtualAllocatorState){
+			    .committed = virtual_commit(arena->memory_block, 0, initial_size)};
 			break;
 		case COUNT:
 		default:
@@ -85,8 +201,7 @@ MemoryArena *memory_arena_create(const AllocatorType type, const size_t alignmen
 	INVARIANT(arena->memory_block->next == NULL, ERR_EQUAL, "memory_block->next", "NULL",
 	          (size_t)arena->memory_block->next, 0);
 
-	arena->memory_block->memory = safe_aligned_alloc(arena->memory_block->capacity, alignment);
-
+	arena_registry_add(arena);
 	return arena;
 }
 
@@ -94,6 +209,15 @@ void memory_arena_destroy(MemoryArena **const arena) {
 	INVARIANT((*arena), ERR_NULL_POINTER, "arena");
 	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
 
+	arena_registry_remove(*arena);
+
+	if ((*arena)->mapping_policy.spare) {
+		block_spare_destroy((*arena)->mapping_policy.spare);
+	}
+	for (MemoryBlock *current = (*arena)->large_blocks, *n; current && (n = current->next, 1); current = n) {
+		memory_block_destroy(current);
+	}
+
 	switch ((*arena)->allocator_type) {
 		case SCRATCH:
 			scratch_free((*arena)->memory_block);
@@ -108,52 +232,121 @@ void memory_arena_destroy(MemoryArena **const arena) {
 		case POOL:
 			pool_free((*arena)->memory_block);
 			break;
+		case CONCURRENT:
+			concurrent_free((*arena)->memory_block);
+			break;
+		case SIZE_CLASS:
+			free((*arena)->state.sizeClassAllocatorState.table);
+			size_class_free((*arena)->memory_block);
+			break;
+		case VIRTUAL:
+			virtual_free((*arena)->memory_block);
+			break;
 		case COUNT:
 		default:
 			INVARIANT(0, ERR_INVALID_ALLOCATOR_TYPE, COUNT, (*arena)->allocator_type);
 	}
-	free(*arena);
+	// The arena was released together with its head block.
 	(*arena) = NULL;
 }
 
+/*
+ * Bytes taken from the blocks of an arena, including its large blocks. CONCURRENT arenas may
+ * claim past the end of a block before moving on, so the allocation offset is capped at the
+ * capacity.
+ */
+static size_t memory_arena_used(MemoryArena *const arena) {
+	size_t used = 0;
+	for (MemoryBlock *current = arena->memory_block; current; current = current->next) {
+		const size_t allocated = __atomic_load_n(&current->allocated, __ATOMIC_RELAXED);
+		used += allocated < current->capacity ? allocated : current->capacity;
+	}
+	for (MemoryBlock *current = arena->large_blocks; current; current = current->next) {
+		used += current->allocated;
+	}
+	return used;
+}
+
+/*
+ * Raises the high water mark of an arena to the bytes it currently uses and returns them.
+ */
+static size_t memory_arena_sample(MemoryArena *const arena) {
+	const size_t used = memory_arena_used(arena);
+	if (used > arena->stats.high_water) {
+		arena->stats.high_water = used;
+	}
+	return used;
+}
+
 void memory_arena_reset(MemoryArena **const arena) {
 	INVARIANT((*arena), ERR_NULL_POINTER, "arena");
 	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
 
+	memory_arena_sample(*arena);
+
+	if ((*arena)->large_blocks) {
+		memory_block_chain_release((*arena)->large_blocks, &(*arena)->mapping_policy);
+		(*arena)->large_blocks = NULL;
+	}
+
 	switch ((*arena)->allocator_type) {
 		case SCRATCH:
-			scratch_reset((*arena)->memory_block);
-			return;
+			scratch_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			break;
 		case LINEAR:
-			linear_reset((*arena)->memory_block);
-			return;
+			linear_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			(*arena)->state.linearAllocatorState.cursor = (*arena)->memory_block;
+			break;
 		case STACK:
-			stack_reset((*arena)->memory_block);
+			stack_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
 			(*arena)->state.stackAllocatorState.top = (*arena)->memory_block;
-			return;
+			break;
 		case POOL:
-			pool_reset((*arena)->memory_block);
-			return;
+			pool_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			(*arena)->state.poolAllocatorState.free_list = NULL;
+			(*arena)->state.poolAllocatorState.cursor = (*arena)->memory_block;
+			break;
+		case CONCURRENT:
+			concurrent_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			(*arena)->state.concurrentAllocatorState.current = (*arena)->memory_block;
+			break;
+		case SIZE_CLASS:
+			size_class_reset((*arena)->memory_block, (*arena)->state.sizeClassAllocatorState.table,
+			                 &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			(*arena)->state.sizeClassAllocatorState.cursor = (*arena)->memory_block;
+			break;
+		case VIRTUAL:
+			virtual_reset((*arena)->memory_block, &(*arena)->reset_policy, &(*arena)->mapping_policy);
+			break;
 		case COUNT:
 		default:
 			INVARIANT(0, ERR_INVALID_ALLOCATOR_TYPE, COUNT, (*arena)->allocator_type);
 	}
-	__builtin_unreachable();
-}
 
-void *memory_arena_alloc(MemoryArena **const arena, const size_t size) {
-	INVARIANT(*arena, ERR_NULL_POINTER, "arena");
-	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	__atomic_store_n(&(*arena)->stats.requested, 0, __ATOMIC_RELAXED);
+}
 
+/*
+ * Allocates from the allocator of the arena without counting the allocation.
+ */
+static inline __attribute__((always_inline)) void *memory_arena_dispatch(MemoryArena **const arena,
+                                                                         const size_t size) {
 	switch ((*arena)->allocator_type) {
 		case SCRATCH:
 			return scratch_alloc(arena, size);
 		case LINEAR:
 			return linear_alloc(arena, size);
 		case STACK:
-			return stack_alloc(&(*arena)->state.stackAllocatorState.top, size, (*arena)->alignment);
+			return stack_alloc(&(*arena)->state.stackAllocatorState.top, size, (*arena)->alignment,
+			                   &(*arena)->mapping_policy);
 		case POOL:
 			return pool_alloc(arena, size);
+		case CONCURRENT:
+			return concurrent_alloc(arena, size);
+		case SIZE_CLASS:
+			return size_class_alloc(arena, size);
+		case VIRTUAL:
+			return virtual_alloc(arena, size);
 		case COUNT:
 		default:
 			INVARIANT(0, "Memory arena tried to allocate with unexpected arena type");
@@ -161,6 +354,179 @@ void *memory_arena_alloc(MemoryArena **const arena, const size_t size) {
 	__builtin_unreachable();
 }
 
+void *memory_arena_alloc(MemoryArena **const arena, const size_t size) {
+	HOT_INVARIANT(*arena, ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+
+	void *result = memory_arena_dispatch(arena, size);
+	if (likely(result)) {
+		memory_arena_count(*arena, 1, size);
+	}
+	return result;
+}
+
+void *memory_arena_alloc_aligned(MemoryArena **const arena, const size_t size, const size_t alignment) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(alignment <= MEMORY_ARENA_MAX_ALIGNMENT, ERR_ALLOC_ALIGNMENT_TOO_LARGE,
+	              MEMORY_ARENA_MAX_ALIGNMENT, alignment);
+
+	const size_t effective = alignment > (*arena)->alignment ? alignment : (*arena)->alignment;
+
+	void *result;
+	switch ((*arena)->allocator_type) {
+		case SCRATCH:
+			result = scratch_alloc_aligned(arena, size, effective);
+			break;
+		case LINEAR:
+			result = linear_alloc_aligned(arena, size, effective);
+			break;
+		case STACK:
+			result = stack_alloc(&(*arena)->state.stackAllocatorState.top, size, effective,
+			                     &(*arena)->mapping_policy);
+			break;
+		case POOL:
+			// Slots sit back to back at the arena alignment, a stricter alignment can not be honoured.
+			result = effective == (*arena)->alignment ? pool_alloc(arena, size) : NULL;
+			break;
+		case CONCURRENT:
+			result = concurrent_alloc_aligned(arena, size, effective);
+			break;
+		case SIZE_CLASS:
+			result = size_class_alloc_aligned(arena, size, effective);
+			break;
+		case VIRTUAL:
+			result = virtual_alloc_aligned(arena, size, effective);
+			break;
+		case COUNT:
+		default:
+			INVARIANT(0, "Memory arena tried to allocate with unexpected arena type");
+	}
+
+	if (likely(result)) {
+		memory_arena_count(*arena, 1, size);
+	}
+	return result;
+}
+
+/*
+ * Allocates the objects of a batch one at a time, for arenas whose objects are freed one at a
+ * time. Objects already allocated are freed again if the batch does not fit, except for large
+ * SIZE_CLASS allocations, whose free is a no-op.
+ */
+static bool memory_arena_alloc_each(MemoryArena **const arena, const size_t *const sizes, const size_t size,
+                                    const size_t count, void **const out) {
+	for (size_t i = 0; i < count; i++) {
+		out[i] = memory_arena_alloc(arena, sizes ? sizes[i] : size);
+		if (unlikely(!out[i])) {
+			while (i--) {
+				memory_arena_free(arena, out[i]);
+				out[i] = NULL;
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool memory_arena_alloc_batch(MemoryArena **const arena, const size_t *const sizes, const size_t count,
+                              void **const out) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(sizes || count == 0, ERR_NULL_POINTER, "sizes");
+	HOT_INVARIANT(out || count == 0, ERR_NULL_POINTER, "out");
+
+	if (count == 0) {
+		return true;
+	}
+	if ((*arena)->allocator_type == POOL || (*arena)->allocator_type == SIZE_CLASS) {
+		return memory_arena_alloc_each(arena, sizes, 0, count, out);
+	}
+
+	/*
+	 * NOTE: The offset of every object is stored in `out` while the batch is measured and
+	 * turned into a pointer once the whole batch has been allocated.
+	 */
+	const size_t alignment = (*arena)->alignment;
+	size_t offset = 0;
+	size_t requested = 0;
+	for (size_t i = 0; i < count - 1; i++) {
+		HOT_INVARIANT(sizes[i] != 0, ERR_ALLOC_SIZE_ZERO);
+		INVARIANT(sizes[i] <= SIZE_MAX - alignment - offset, ERR_ALLOCATION_TOO_LARGE, sizes[i],
+		          SIZE_MAX - alignment - offset);
+		out[i] = (void *)(uintptr_t)offset;
+		offset += (sizes[i] + (alignment - 1)) & ~(alignment - 1);
+		requested += sizes[i];
+	}
+	HOT_INVARIANT(sizes[count - 1] != 0, ERR_ALLOC_SIZE_ZERO);
+	INVARIANT(sizes[count - 1] <= SIZE_MAX - offset, ERR_ALLOCATION_TOO_LARGE, sizes[count - 1],
+	          SIZE_MAX - offset);
+	out[count - 1] = (void *)(uintptr_t)offset;
+
+	char *base = memory_arena_dispatch(arena, offset + sizes[count - 1]);
+	if (unlikely(!base)) {
+		memset(out, 0x0, count * sizeof(void *));
+		return false;
+	}
+	memory_arena_count(*arena, count, requested + sizes[count - 1]);
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] = base + (uintptr_t)out[i];
+	}
+	return true;
+}
+
+bool memory_arena_alloc_batch_uniform(MemoryArena **const arena, const size_t size, const size_t count,
+                                      void **const out) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(out || count == 0, ERR_NULL_POINTER, "out");
+	HOT_INVARIANT(size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	if (count == 0) {
+		return true;
+	}
+	if ((*arena)->allocator_type == POOL || (*arena)->allocator_type == SIZE_CLASS) {
+		return memory_arena_alloc_each(arena, NULL, size, count, out);
+	}
+
+	const size_t alignment = (*arena)->alignment;
+	INVARIANT(size <= SIZE_MAX - alignment, ERR_ALLOCATION_TOO_LARGE, size, SIZE_MAX - alignment);
+	const size_t stride = (size + (alignment - 1)) & ~(alignment - 1);
+	INVARIANT(count - 1 <= (SIZE_MAX - size) / stride, ERR_ALLOCATION_TOO_LARGE, count, (SIZE_MAX - size) / stride);
+
+	char *base = memory_arena_dispatch(arena, stride * (count - 1) + size);
+	if (unlikely(!base)) {
+		memset(out, 0x0, count * sizeof(void *));
+		return false;
+	}
+	memory_arena_count(*arena, count, size * count);
+
+	for (size_t i = 0; i < count; i++) {
+		out[i] = base + i * stride;
+	}
+	return true;
+}
+
+void memory_arena_free(MemoryArena **const arena, void *const ptr) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	INVARIANT((*arena)->allocator_type == POOL || (*arena)->allocator_type == SIZE_CLASS,
+	          ERR_OPERATION_INVALID_FOR_STATE, "free", "arena", get_allocator_type_name((*arena)->allocator_type));
+
+	if ((*arena)->allocator_type == POOL) {
+		pool_dealloc(arena, ptr);
+	} else {
+		size_class_dealloc(arena, ptr);
+	}
+}
+
+size_t memory_arena_size_class_occupancy(MemoryArena *const arena, MemorySizeClassOccupancy *const occupancy,
+                                         const size_t count) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(arena->allocator_type == SIZE_CLASS, ERR_OPERATION_INVALID_FOR_STATE, "occupancy", "arena",
+	          get_allocator_type_name(arena->allocator_type));
+
+	return size_class_occupancy(arena->state.sizeClassAllocatorState.table, occupancy, count);
+}
+
 bool memory_arena_alloc_verify(MemoryArena *const arena, const size_t size) {
 	INVARIANT(arena, ERR_NULL_POINTER, "arena");
 	INVARIANT(arena->memory_block, ERR_NULL_POINTER, "arena->memory_block");
@@ -171,9 +537,16 @@ bool memory_arena_alloc_verify(MemoryArena *const arena, const size_t size) {
 		case LINEAR:
 			return linear_alloc_verify(arena, size);
 		case STACK:
-			return stack_alloc_verify(arena->state.stackAllocatorState.top, size, arena->alignment);
+			return stack_alloc_verify(arena->state.stackAllocatorState.top, size, arena->alignment,
+			                          &arena->mapping_policy);
 		case POOL:
 			return pool_alloc_verify(arena, size);
+		case CONCURRENT:
+			return concurrent_alloc_verify(arena, size);
+		case SIZE_CLASS:
+			return size_class_alloc_verify(arena, size);
+		case VIRTUAL:
+			return virtual_alloc_verify(arena, size);
 		case COUNT:
 		default:
 			INVARIANT(0, ERR_INVALID_ALLOCATOR_TYPE, COUNT, arena->allocator_type);
@@ -181,6 +554,44 @@ bool memory_arena_alloc_verify(MemoryArena *const arena, const size_t size) {
 	__builtin_unreachable();
 }
 
+void memory_arena_get_stats(MemoryArena *const arena, MemoryArenaStats *const stats) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(stats, ERR_NULL_POINTER, "stats");
+
+	const MappingPolicy *const mapping = &arena->mapping_policy;
+	const size_t used = memory_arena_sample(arena);
+	const size_t requested = __atomic_load_n(&arena->stats.requested, __ATOMIC_RELAXED);
+
+	/*
+	 * NOTE: Freed POOL and SIZE_CLASS slots stay in use by the blocks and carved runs are used
+	 * before any slot is handed out, so only bump allocated arenas report their padding.
+	 */
+	const bool bump = arena->allocator_type != POOL && arena->allocator_type != SIZE_CLASS;
+
+	*stats = (MemoryArenaStats){
+	    .allocations = __atomic_load_n(&arena->stats.allocations, __ATOMIC_RELAXED),
+	    .bytes_requested = requested,
+	    .bytes_used = used,
+	    .padding = ANVIL_MEMORY_STATS && bump && used > requested ? used - requested : 0,
+	    .high_water = arena->stats.high_water,
+	    .blocks = __atomic_load_n(&mapping->blocks, __ATOMIC_RELAXED),
+	    .capacity = __atomic_load_n(&mapping->capacity, __ATOMIC_RELAXED),
+	    .block_maps = __atomic_load_n(&mapping->maps, __ATOMIC_RELAXED),
+	    .block_reuses = __atomic_load_n(&mapping->reuses, __ATOMIC_RELAXED),
+	    .block_releases = __atomic_load_n(&mapping->releases, __ATOMIC_RELAXED),
+	    .block_unmaps = __atomic_load_n(&mapping->unmaps, __ATOMIC_RELAXED),
+	    .page_backing = mapping->page_backing,
+	};
+}
+
+void memory_arena_get_global_stats(MemoryGlobalStats *const stats) {
+	INVARIANT(stats, ERR_NULL_POINTER, "stats");
+
+	arena_registry_collect(stats);
+	stats->mmap_calls = safe_mmap_calls();
+	stats->munmap_calls = safe_munmap_calls();
+}
+
 void memory_stack_arena_record(MemoryArena **const memory_arena) {
 	INVARIANT(memory_arena && (*memory_arena), ERR_NULL_POINTER, "memory_arena");
 	INVARIANT((*memory_arena)->allocator_type == STACK, ERR_OPERATION_INVALID_FOR_STATE, "record", "arena",
@@ -204,7 +615,24 @@ void memory_stack_arena_record(MemoryArena **const memory_arena) {
 	new_snapshot->top = stack_state->top;
 	new_snapshot->allocated = stack_state->top->allocated;
 	new_snapshot->capacity = stack_state->top->capacity;
+	new_snapshot->requested = current_arena->stats.requested;
 	stack_state->snapshot_count++;
+	stack_state->top->pinned = stack_state->top->allocated;
+}
+
+/*
+ * Moves the top of a stack arena back to `allocated` bytes into `top`, caching or releasing the
+ * blocks past it, and restores the requested byte count of that point.
+ */
+static void memory_stack_arena_rewind(MemoryArena *const arena, MemoryBlock *const top, const size_t allocated,
+                                      const size_t requested) {
+	StackAllocatorState *stack_state = &arena->state.stackAllocatorState;
+	memory_arena_sample(arena);
+	__atomic_store_n(&arena->stats.requested, requested, __ATOMIC_RELAXED);
+
+	memory_block_rewind(top, allocated, &arena->reset_policy);
+	stack_state->top = top;
+	stack_cache(stack_state->top, &stack_state->cache_idle, &arena->reset_policy, &arena->mapping_policy);
 }
 
 void memory_stack_arena_unwind(MemoryArena **const memory_arena) {
@@ -217,15 +645,10 @@ void memory_stack_arena_unwind(MemoryArena **const memory_arena) {
 	MemoryArena *current_arena = (*memory_arena);
 	StackAllocatorState *stack_state = &current_arena->state.stackAllocatorState;
 	Snapshot target_snapshot = stack_state->snapshots[stack_state->snapshot_count - 1];
-	stack_state->top = target_snapshot.top;
-	stack_state->top->capacity = target_snapshot.capacity;
-	stack_state->top->allocated = target_snapshot.allocated;
-
-	if (target_snapshot.top->next) {
-		stack_free(target_snapshot.top->next);
-	}
 
-	stack_state->top->next = NULL;
+	target_snapshot.top->capacity = target_snapshot.capacity;
+	memory_stack_arena_rewind(current_arena, target_snapshot.top, target_snapshot.allocated,
+	                          target_snapshot.requested);
 	stack_state->snapshot_count--;
 
 	if (current_arena->state.stackAllocatorState.snapshot_count <
@@ -235,6 +658,165 @@ void memory_stack_arena_unwind(MemoryArena **const memory_arena) {
 	}
 }
 
+MemoryStackMark memory_stack_arena_mark(MemoryArena *const arena) {
+	HOT_INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(arena->allocator_type == STACK, ERR_OPERATION_INVALID_FOR_STATE, "mark", "arena",
+	          get_allocator_type_name(arena->allocator_type));
+
+	const StackAllocatorState *stack_state = &arena->state.stackAllocatorState;
+	stack_state->top->pinned = stack_state->top->allocated;
+	return (MemoryStackMark){
+	    .block = stack_state->top,
+	    .allocated = stack_state->top->allocated,
+	    .requested = __atomic_load_n(&arena->stats.requested, __ATOMIC_RELAXED),
+	    .snapshots = stack_state->snapshot_count,
+	};
+}
+
+/*
+ * Whether a mark lies on the chain of a stack arena at or before its current position.
+ */
+static bool memory_stack_mark_reachable(const MemoryArena *const arena, const MemoryStackMark *const mark) {
+	const MemoryBlock *const top = arena->state.stackAllocatorState.top;
+	for (const MemoryBlock *current = arena->memory_block; current; current = current->next) {
+		if (current == mark->block) {
+			return mark->allocated <= (current == top ? top->allocated : current->capacity);
+		}
+		if (current == top) {
+			return false;
+		}
+	}
+	return false;
+}
+
+void memory_stack_arena_restore(MemoryArena **const memory_arena, const MemoryStackMark mark) {
+	HOT_INVARIANT(memory_arena && (*memory_arena), ERR_NULL_POINTER, "memory_arena");
+	INVARIANT((*memory_arena)->allocator_type == STACK, ERR_OPERATION_INVALID_FOR_STATE, "restore", "arena",
+	          get_allocator_type_name((*memory_arena)->allocator_type));
+	HOT_INVARIANT(mark.block, ERR_NULL_POINTER, "mark.block");
+	HOT_INVARIANT(mark.snapshots <= (*memory_arena)->state.stackAllocatorState.snapshot_count, ERR_LESS_EQUAL,
+	              "mark.snapshots", "snapshot_count", mark.snapshots,
+	              (*memory_arena)->state.stackAllocatorState.snapshot_count);
+	PARANOID_INVARIANT(memory_stack_mark_reachable(*memory_arena, &mark), ERR_OPERATION_INVALID_FOR_STATE,
+	                   "restore", "mark", "past the top of the stack");
+
+	MemoryArena *current_arena = (*memory_arena);
+	memory_stack_arena_rewind(current_arena, mark.block, mark.allocated, mark.requested);
+	current_arena->state.stackAllocatorState.snapshot_count = mark.snapshots;
+}
+
+/*
+ * Block the allocations of a bump allocated arena advance through, NULL for the allocator types
+ * that are not bump allocated.
+ */
+static MemoryBlock *memory_arena_active_block(const MemoryArena *const arena) {
+	switch (arena->allocator_type) {
+		case SCRATCH:
+		case VIRTUAL:
+			return arena->memory_block;
+		case LINEAR:
+			return arena->state.linearAllocatorState.cursor;
+		case STACK:
+			return arena->state.stackAllocatorState.top;
+		case CONCURRENT:
+			return __atomic_load_n(&arena->state.concurrentAllocatorState.current, __ATOMIC_ACQUIRE);
+		case POOL:
+		case SIZE_CLASS:
+		case COUNT:
+		default:
+			return NULL;
+	}
+}
+
+MemoryArenaCheckpoint memory_arena_checkpoint(MemoryArena *const arena) {
+	HOT_INVARIANT(arena, ERR_NULL_POINTER, "arena");
+
+	MemoryBlock *const active = memory_arena_active_block(arena);
+	INVARIANT(active, ERR_OPERATION_INVALID_FOR_STATE, "checkpoint", "arena",
+	          get_allocator_type_name(arena->allocator_type));
+
+	// Failed CONCURRENT claims may leave the offset past the capacity of the block.
+	const size_t offset = active->allocated < active->capacity ? active->allocated : active->capacity;
+	active->pinned = offset;
+
+	size_t position = offset;
+	for (const MemoryBlock *current = arena->memory_block; current != active; current = current->next) {
+		position += current->capacity;
+	}
+
+	const size_t snapshots = arena->allocator_type == STACK ? arena->state.stackAllocatorState.snapshot_count : 0;
+	return (MemoryArenaCheckpoint){.position = position, .large = arena->large_blocks, .snapshots = snapshots};
+}
+
+void memory_arena_rollback(MemoryArena **const arena, const MemoryArenaCheckpoint checkpoint) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+
+	MemoryArena *current_arena = (*arena);
+	MemoryBlock *const active = memory_arena_active_block(current_arena);
+	INVARIANT(active, ERR_OPERATION_INVALID_FOR_STATE, "rollback", "arena",
+	          get_allocator_type_name(current_arena->allocator_type));
+	INVARIANT(current_arena->allocator_type != STACK ||
+	              checkpoint.snapshots <= current_arena->state.stackAllocatorState.snapshot_count,
+	          ERR_LESS_EQUAL, "checkpoint.snapshots", "snapshot_count", checkpoint.snapshots,
+	          current_arena->state.stackAllocatorState.snapshot_count);
+
+	memory_arena_sample(current_arena);
+
+	// Large blocks are pushed to the front of their list, so the ones mapped since come first.
+	while (current_arena->large_blocks != checkpoint.large) {
+		MemoryBlock *const large = current_arena->large_blocks;
+		INVARIANT(large, ERR_OPERATION_INVALID_FOR_STATE, "rollback", "checkpoint", "not taken from this arena");
+		current_arena->large_blocks = large->next;
+		large->next = NULL;
+		memory_block_chain_release(large, &current_arena->mapping_policy);
+	}
+
+	/*
+	 * NOTE: A position at the end of a block before the active one is taken as the start of the
+	 * block after it, which the arena had moved on to or moves on to next.
+	 */
+	MemoryBlock *target = current_arena->memory_block;
+	size_t offset = checkpoint.position;
+	while (target != active && offset >= target->capacity) {
+		offset -= target->capacity;
+		target = target->next;
+	}
+	INVARIANT(offset <= target->allocated, ERR_OPERATION_INVALID_FOR_STATE, "rollback", "checkpoint",
+	          "past the current position");
+
+	const ResetPolicy *const policy = &current_arena->reset_policy;
+	memory_block_rewind(target, offset, policy);
+
+	switch (current_arena->allocator_type) {
+		case LINEAR:
+			for (MemoryBlock *current = target->next; current; current = current->next) {
+				memory_block_rewind(current, 0, policy);
+			}
+			current_arena->state.linearAllocatorState.cursor = target;
+			break;
+		case CONCURRENT:
+			for (MemoryBlock *current = target->next; current; current = current->next) {
+				memory_block_rewind(current, 0, policy);
+			}
+			__atomic_store_n(&current_arena->state.concurrentAllocatorState.current, target, __ATOMIC_RELEASE);
+			break;
+		case STACK:
+			current_arena->state.stackAllocatorState.top = target;
+			current_arena->state.stackAllocatorState.snapshot_count = checkpoint.snapshots;
+			stack_cache(target, &current_arena->state.stackAllocatorState.cache_idle, policy,
+			            &current_arena->mapping_policy);
+			break;
+		case SCRATCH:
+		case VIRTUAL:
+		case POOL:
+		case SIZE_CLASS:
+		case COUNT:
+		default:
+			// Single block arenas only rewind their offset.
+			break;
+	}
+}
+
 void *memory_arena_move(MemoryArena **const arena, void **const src, const size_t size, void (*free_fptr)(void *)) {
 	INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
 	INVARIANT(src && (*src), ERR_NULL_POINTER, "src");
@@ -255,6 +837,73 @@ void *memory_arena_move(MemoryArena **const arena, void **const src, const size_
 	return dest;
 }
 
+void *memory_arena_realloc(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size) {
+	HOT_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(new_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	if (!ptr) {
+		return memory_arena_alloc(arena, new_size);
+	}
+	HOT_INVARIANT(old_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	bool resized;
+	switch ((*arena)->allocator_type) {
+		case SCRATCH:
+			resized = memory_block_resize_last((*arena)->memory_block, ptr, old_size, new_size);
+			break;
+		case LINEAR:
+			resized = memory_block_resize_last((*arena)->state.linearAllocatorState.cursor, ptr, old_size,
+			                                   new_size) ||
+			          ((*arena)->large_blocks &&
+			           memory_block_resize_last((*arena)->large_blocks, ptr, old_size, new_size));
+			break;
+		case STACK:
+			resized =
+			    memory_block_resize_last((*arena)->state.stackAllocatorState.top, ptr, old_size, new_size);
+			break;
+		case POOL:
+			resized = new_size <= (*arena)->state.poolAllocatorState.slot_size;
+			break;
+		case CONCURRENT:
+			resized = concurrent_resize(arena, ptr, old_size, new_size);
+			break;
+		case SIZE_CLASS:
+			resized = size_class_resize(arena, ptr, old_size, new_size);
+			break;
+		case VIRTUAL:
+			resized = virtual_resize(arena, ptr, old_size, new_size);
+			break;
+		case COUNT:
+		default:
+			INVARIANT(0, ERR_INVALID_ALLOCATOR_TYPE, COUNT, (*arena)->allocator_type);
+	}
+
+	/*
+	 * NOTE: An allocation that can not be resized in place still has room for any smaller
+	 * size, so only growing it has to move it.
+	 */
+	if (resized) {
+		// Sizes are unsigned, so a shrink subtracts from the bytes requested by wrapping around.
+		memory_arena_count(*arena, 0, new_size - old_size);
+		return ptr;
+	}
+	if (new_size <= old_size) {
+		return ptr;
+	}
+
+	void *result = memory_arena_alloc(arena, new_size);
+	if (!result) {
+		return NULL;
+	}
+
+	memcpy(result, ptr, old_size);
+	if ((*arena)->allocator_type == POOL || (*arena)->allocator_type == SIZE_CLASS) {
+		memory_arena_free(arena, ptr);
+	}
+
+	return result;
+}
+
 void *memory_arena_copy(MemoryArena **const arena, const void *const src, const size_t size) {
 	INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
 	INVARIANT(src, ERR_NULL_POINTER, "src");
@@ -0,0 +1,94 @@
+#include "anvil/memory/internal/allocation/block_recycler_internal.h"
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include <stdint.h>
+
+static MemoryBlock *recycled_blocks[BLOCK_RECYCLER_SLOTS];
+
+/*
+ * Occupied slots, so creating a block skips the scan while the recycler is empty. A slot is
+ * counted after it is filled and uncounted after it is emptied, so the count may briefly
+ * wrap below zero and is only ever used as a hint.
+ */
+static size_t recycled_count;
+
+/*
+ * Parks a block in the first empty slot. Returns false when every slot is occupied.
+ */
+static bool block_recycler_park(MemoryBlock *const memory_block) {
+	for (size_t slot = 0; slot < BLOCK_RECYCLER_SLOTS; slot++) {
+		MemoryBlock *expected = NULL;
+		if (__atomic_load_n(&recycled_blocks[slot], __ATOMIC_RELAXED) == NULL &&
+		    __atomic_compare_exchange_n(&recycled_blocks[slot], &expected, memory_block, false,
+		                                __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			__atomic_fetch_add(&recycled_count, 1, __ATOMIC_RELAXED);
+			return true;
+		}
+	}
+	return false;
+}
+
+MemoryBlock *block_recycler_acquire(const size_t capacity, const size_t alignment, const bool huge_pages) {
+	if (__atomic_load_n(&recycled_count, __ATOMIC_RELAXED) == 0) {
+		return NULL;
+	}
+
+	for (size_t slot = 0; slot < BLOCK_RECYCLER_SLOTS; slot++) {
+		if (__atomic_load_n(&recycled_blocks[slot], __ATOMIC_RELAXED) == NULL) {
+			continue;
+		}
+
+		MemoryBlock *memory_block = __atomic_exchange_n(&recycled_blocks[slot], NULL, __ATOMIC_ACQUIRE);
+		if (!memory_block) {
+			continue;
+		}
+		__atomic_fetch_sub(&recycled_count, 1, __ATOMIC_RELAXED);
+
+		size_t usable = safe_aligned_usable_size(memory_block->memory);
+		bool huge = safe_aligned_page_backing(memory_block->memory) != MEMORY_PAGES_DEFAULT;
+		// Waste is bounded by the capacity the block was mapped with. The usable size also counts
+		// the alignment slack of the mapping, and the capacity it last held shrinks with every reuse.
+		if (((uintptr_t)memory_block->memory & (alignment - 1)) == 0 && usable >= capacity &&
+		    memory_block->mapped / 2 < capacity && huge == huge_pages) {
+			memory_block->capacity = capacity;
+			memory_block->allocated = 0;
+			memory_block->dirty = 0;
+			memory_block->pinned = 0;
+			memory_block->next = NULL;
+			return memory_block;
+		}
+
+		if (!block_recycler_park(memory_block)) {
+			memory_block_unmap(memory_block);
+		}
+	}
+	return NULL;
+}
+
+bool block_recycler_release(MemoryBlock *const memory_block) {
+	size_t usable = safe_aligned_usable_size(memory_block->memory);
+	if (usable > BLOCK_RECYCLER_MAX_BLOCK_SIZE) {
+		return false;
+	}
+
+	// Bytes left behind by rewinds of arenas that do not zero are cleared along with the used ones.
+	memory_block_zero(memory_block, memory_block_touched(memory_block), MEMORY_RESET_ZERO_RELEASE,
+	                  RESET_RELEASE_DEFAULT_THRESHOLD);
+	memory_block->allocated = 0;
+	memory_block->dirty = 0;
+	memory_block->pinned = 0;
+	memory_block->next = NULL;
+
+	return block_recycler_park(memory_block);
+}
+
+void block_recycler_drain(void) {
+	for (size_t slot = 0; slot < BLOCK_RECYCLER_SLOTS; slot++) {
+		MemoryBlock *memory_block = __atomic_exchange_n(&recycled_blocks[slot], NULL, __ATOMIC_ACQUIRE);
+		if (memory_block) {
+			__atomic_fetch_sub(&recycled_count, 1, __ATOMIC_RELAXED);
+			memory_block_unmap(memory_block);
+		}
+	}
+}
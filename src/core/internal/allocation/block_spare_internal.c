@@ -0,0 +1,143 @@
+#include "anvil/memory/internal/allocation/block_spare_internal.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+static pthread_mutex_t spare_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spare_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t spare_idle = PTHREAD_COND_INITIALIZER;
+static BlockSpare *spare_queue = NULL;
+static bool spare_thread_started = false;
+
+/*
+ * Refill thread, prepares the block of every queued spare in turn. The lock is dropped while
+ * a block is mapped and prefaulted, `busy` keeps the spare alive until it is published.
+ */
+static void *block_spare_thread(void *unused) {
+	(void)unused;
+
+	pthread_mutex_lock(&spare_lock);
+	for (;;) {
+		while (!spare_queue) {
+			pthread_cond_wait(&spare_work, &spare_lock);
+		}
+
+		BlockSpare *spare = spare_queue;
+		spare_queue = spare->next;
+		spare->next = NULL;
+		spare->queued = false;
+		spare->busy = true;
+		const size_t capacity = spare->capacity;
+		pthread_mutex_unlock(&spare_lock);
+
+		const size_t reuses = spare->mapping.reuses;
+		MemoryBlock *memory_block = memory_block_create(capacity, spare->alignment, &spare->mapping);
+		spare->reused = spare->mapping.reuses != reuses;
+		MemoryBlock *stale = __atomic_exchange_n(&spare->ready, memory_block, __ATOMIC_RELEASE);
+		if (stale) {
+			memory_block_destroy(stale);
+		}
+
+		pthread_mutex_lock(&spare_lock);
+		spare->busy = false;
+		pthread_cond_broadcast(&spare_idle);
+	}
+
+	return NULL;
+}
+
+BlockSpare *block_spare_create(const MappingPolicy *const mapping, const size_t alignment) {
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+
+	BlockSpare *spare = calloc(1, sizeof(BlockSpare));
+	INVARIANT(spare, ERR_OUT_OF_MEMORY, sizeof(BlockSpare));
+
+	spare->mapping = (MappingPolicy){
+	    .page_backing = mapping->page_backing,
+	    .numa_policy = mapping->numa_policy,
+	    .huge_pages = mapping->huge_pages,
+	    .sensitive = mapping->sensitive,
+	    .prefault = true,
+	    .numa_node = mapping->numa_node,
+	};
+	spare->alignment = alignment;
+
+	return spare;
+}
+
+MemoryBlock *block_spare_take(BlockSpare *const spare, const size_t capacity, const size_t alignment,
+                              bool *const reused) {
+	PARANOID_INVARIANT(spare, ERR_NULL_POINTER, "spare");
+
+	MemoryBlock *memory_block = __atomic_exchange_n(&spare->ready, NULL, __ATOMIC_ACQUIRE);
+	if (!memory_block) {
+		return NULL;
+	}
+
+	if (memory_block->capacity < capacity || ((uintptr_t)memory_block->memory & (alignment - 1)) != 0) {
+		memory_block_destroy(memory_block);
+		return NULL;
+	}
+
+	memory_block->capacity = capacity;
+	*reused = spare->reused;
+	return memory_block;
+}
+
+void block_spare_refill(BlockSpare *const spare, const size_t capacity) {
+	INVARIANT(spare, ERR_NULL_POINTER, "spare");
+	INVARIANT(capacity != 0, ERR_ZERO_CAPACITY, capacity);
+
+	if (__atomic_load_n(&spare->ready, __ATOMIC_RELAXED)) {
+		return;
+	}
+
+	pthread_mutex_lock(&spare_lock);
+	spare->capacity = capacity;
+	if (!spare_thread_started) {
+		pthread_t thread;
+		pthread_attr_t attributes;
+		pthread_attr_init(&attributes);
+		pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+		int result = pthread_create(&thread, &attributes, block_spare_thread, NULL);
+		pthread_attr_destroy(&attributes);
+		INVARIANT(result == 0, ERR_INVALID_STATE, "spare refill thread", "started", "failed");
+		spare_thread_started = true;
+	}
+	if (!spare->queued && !spare->busy) {
+		spare->queued = true;
+		spare->next = spare_queue;
+		spare_queue = spare;
+		pthread_cond_signal(&spare_work);
+	}
+	pthread_mutex_unlock(&spare_lock);
+}
+
+void block_spare_destroy(BlockSpare *const spare) {
+	INVARIANT(spare, ERR_NULL_POINTER, "spare");
+
+	pthread_mutex_lock(&spare_lock);
+	if (spare->queued) {
+		BlockSpare **link = &spare_queue;
+		while (*link != spare) {
+			link = &(*link)->next;
+		}
+		*link = spare->next;
+		spare->queued = false;
+	}
+	while (spare->busy) {
+		pthread_cond_wait(&spare_idle, &spare_lock);
+	}
+	pthread_mutex_unlock(&spare_lock);
+
+	MemoryBlock *memory_block = __atomic_exchange_n(&spare->ready, NULL, __ATOMIC_ACQUIRE);
+	if (memory_block) {
+		memory_block_destroy(memory_block);
+	}
+	free(spare);
+}
@@ -5,30 +5,279 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
-void *safe_aligned_alloc(size_t size, size_t alignment) {
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+// Memory policy constants of <linux/mempolicy.h>, the system calls are made without libnuma.
+#define SAFE_MPOL_DEFAULT 0
+#define SAFE_MPOL_BIND 2
+#define SAFE_MPOL_INTERLEAVE 3
+#define SAFE_MPOL_F_MEMS_ALLOWED (1 << 2)
+#define SAFE_MPOL_MF_MOVE (1 << 1)
+
+// Linux 5.14, older C libraries do not define it.
+#define SAFE_MADV_POPULATE_WRITE 23
+
+// Node masks cover MEMORY_NUMA_MAX_NODES nodes, the kernel reads one bit less than `maxnode`.
+#define SAFE_NUMA_WORD_BITS (sizeof(unsigned long) * 8)
+#define SAFE_NUMA_MASK_WORDS (MEMORY_NUMA_MAX_NODES / SAFE_NUMA_WORD_BITS)
+
+static size_t mmap_calls = 0;
+static size_t munmap_calls = 0;
+
+/*
+ * `mmap` and `munmap` counting the calls that succeed, for `memory_arena_get_global_stats`.
+ */
+static inline void *counted_mmap(void *addr, size_t length, int prot, int flags) {
+	void *result = mmap(addr, length, prot, flags, -1, 0);
+	if (result != MAP_FAILED) {
+		__atomic_fetch_add(&mmap_calls, 1, __ATOMIC_RELAXED);
+	}
+	return result;
+}
+
+static inline void counted_munmap(void *addr, size_t length) {
+	if (munmap(addr, length) == 0) {
+		__atomic_fetch_add(&munmap_calls, 1, __ATOMIC_RELAXED);
+	}
+}
+
+/*
+ * Places the metadata of a fresh mapping right before its first aligned address past the
+ * caller's header and returns that address.
+ */
+static void *safe_aligned_place(void *const base, const size_t total_size, const size_t alignment,
+                                const size_t header_size, const MemoryPageBacking backing) {
+	uintptr_t addr = (uintptr_t)base + header_size + sizeof(Metadata);
+	uintptr_t aligned_addr = (addr + alignment - 1) & ~(alignment - 1);
+
+	Metadata *metadata = (Metadata *)(aligned_addr - sizeof(Metadata));
+	metadata->base = base;
+	metadata->total_size = total_size;
+	metadata->backing = backing;
+
+	return (void *)aligned_addr;
+}
+
+void *safe_aligned_alloc(size_t size, size_t alignment, size_t header_size) {
 	INVARIANT(size != 0, ERR_ALLOC_SIZE_ZERO);
 	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
 	INVARIANT(alignment <= (1 << 16), ERR_ALLOC_ALIGNMENT_TOO_LARGE, (size_t)(1 << 16), alignment);
+	INVARIANT(header_size % _Alignof(max_align_t) == 0, ERR_INVALID_STATE, "header_size", "max_align_t multiple",
+	          "misaligned");
 
 	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
-	size_t total_size = size + alignment + sizeof(Metadata);
+	INVARIANT(size <= SIZE_MAX - page_size - alignment - header_size - sizeof(Metadata), ERR_ALLOCATION_TOO_LARGE,
+	          size, SIZE_MAX - page_size - alignment - header_size - sizeof(Metadata));
+	size_t total_size = size + alignment + header_size + sizeof(Metadata);
 
 	total_size = (total_size + page_size - 1) & ~(page_size - 1);
 
-	void *base = mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	void *base = counted_mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
 
 	INVARIANT(base != MAP_FAILED, ERR_OUT_OF_MEMORY, total_size);
 
-	uintptr_t addr = (uintptr_t)base + sizeof(Metadata);
-	uintptr_t aligned_addr = (addr + alignment - 1) & ~(alignment - 1);
+	return safe_aligned_place(base, total_size, alignment, header_size, MEMORY_PAGES_DEFAULT);
+}
 
-	Metadata *metadata = (Metadata *)(aligned_addr - sizeof(Metadata));
-	metadata->base = base;
-	metadata->total_size = total_size;
+void *safe_aligned_alloc_huge(size_t size, size_t alignment, size_t header_size) {
+	INVARIANT(size != 0, ERR_ALLOC_SIZE_ZERO);
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(alignment <= (1 << 16), ERR_ALLOC_ALIGNMENT_TOO_LARGE, (size_t)(1 << 16), alignment);
+	INVARIANT(header_size % _Alignof(max_align_t) == 0, ERR_INVALID_STATE, "header_size", "max_align_t multiple",
+	          "misaligned");
+	INVARIANT(size <= SIZE_MAX - 2 * HUGE_PAGE_SIZE - alignment - header_size, ERR_ALLOCATION_TOO_LARGE, size,
+	          SIZE_MAX - 2 * HUGE_PAGE_SIZE - alignment - header_size);
 
-	return (void *)aligned_addr;
+	/*
+	 * NOTE: Huge mappings start on a huge page boundary, so the headers only cost their size
+	 * rounded up to the alignment rather than a worst case alignment gap.
+	 */
+	size_t header = safe_aligned_header_size(alignment, header_size);
+	size_t total_size = (size + header + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+	void *base = counted_mmap(NULL, total_size, PROT_READ | PROT_WRITE,
+	                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB);
+	if (base != MAP_FAILED) {
+		return safe_aligned_place(base, total_size, alignment, header_size, MEMORY_PAGES_HUGETLB);
+	}
+
+	size_t reserve_size = total_size + HUGE_PAGE_SIZE;
+	void *reserve = counted_mmap(NULL, reserve_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
+
+	INVARIANT(reserve != MAP_FAILED, ERR_OUT_OF_MEMORY, reserve_size);
+
+	uintptr_t aligned_base = ((uintptr_t)reserve + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+	size_t head = aligned_base - (uintptr_t)reserve;
+	size_t tail = reserve_size - head - total_size;
+
+	if (head != 0) {
+		counted_munmap(reserve, head);
+	}
+	if (tail != 0) {
+		counted_munmap((void *)(aligned_base + total_size), tail);
+	}
+
+	base = (void *)aligned_base;
+	MemoryPageBacking backing =
+	    madvise(base, total_size, MADV_HUGEPAGE) == 0 ? MEMORY_PAGES_TRANSPARENT : MEMORY_PAGES_DEFAULT;
+
+	return safe_aligned_place(base, total_size, alignment, header_size, backing);
+}
+
+void *safe_aligned_reserve(size_t size, size_t alignment, size_t header_size, bool huge_pages) {
+	INVARIANT(size != 0, ERR_ALLOC_SIZE_ZERO);
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(alignment <= (1 << 16), ERR_ALLOC_ALIGNMENT_TOO_LARGE, (size_t)(1 << 16), alignment);
+	INVARIANT(header_size % _Alignof(max_align_t) == 0, ERR_INVALID_STATE, "header_size", "max_align_t multiple",
+	          "misaligned");
+
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	INVARIANT(size <= SIZE_MAX - alignment - header_size - sizeof(Metadata) - page_size, ERR_ALLOCATION_TOO_LARGE,
+	          size, SIZE_MAX - alignment - header_size - sizeof(Metadata) - page_size);
+
+	size_t total_size = size + alignment + header_size + sizeof(Metadata);
+	total_size = (total_size + page_size - 1) & ~(page_size - 1);
+
+	void *base = counted_mmap(NULL, total_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE);
+
+	INVARIANT(base != MAP_FAILED, ERR_OUT_OF_MEMORY, total_size);
+
+	/*
+	 * NOTE: Only the pages holding the headers are committed here, the memory itself is committed
+	 * by the caller with `safe_aligned_commit` as it is used.
+	 */
+	uintptr_t memory = ((uintptr_t)base + header_size + sizeof(Metadata) + alignment - 1) & ~(alignment - 1);
+	size_t header_pages = ((memory - (uintptr_t)base) + page_size - 1) & ~(page_size - 1);
+	INVARIANT(mprotect(base, header_pages, PROT_READ | PROT_WRITE) == 0, ERR_OUT_OF_MEMORY, header_pages);
+
+	MemoryPageBacking backing = MEMORY_PAGES_DEFAULT;
+	if (huge_pages && madvise(base, total_size, MADV_HUGEPAGE) == 0) {
+		backing = MEMORY_PAGES_TRANSPARENT;
+	}
+
+	return safe_aligned_place(base, total_size, alignment, header_size, backing);
+}
+
+size_t safe_aligned_commit(void *ptr, size_t committed, size_t size) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+	INVARIANT(size <= safe_aligned_usable_size(ptr), ERR_ALLOCATION_TOO_LARGE, size, safe_aligned_usable_size(ptr));
+
+	if (size <= committed) {
+		return committed;
+	}
+
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)ptr + committed + page_size - 1) & ~(uintptr_t)(page_size - 1);
+	uintptr_t end = ((uintptr_t)ptr + size + page_size - 1) & ~(uintptr_t)(page_size - 1);
+
+	INVARIANT(mprotect((void *)start, end - start, PROT_READ | PROT_WRITE) == 0, ERR_OUT_OF_MEMORY,
+	          (size_t)(end - start));
+
+	return (size_t)(end - (uintptr_t)ptr);
+}
+
+/*
+ * Fills `nodes` with the nodes the process may allocate memory on, node 0 alone if the kernel
+ * can not report them.
+ */
+static void safe_numa_allowed_nodes(unsigned long nodes[SAFE_NUMA_MASK_WORDS]) {
+	if (syscall(SYS_get_mempolicy, NULL, nodes, MEMORY_NUMA_MAX_NODES + 1, NULL, SAFE_MPOL_F_MEMS_ALLOWED) !=
+	    0) {
+		memset(nodes, 0x0, SAFE_NUMA_MASK_WORDS * sizeof(unsigned long));
+		nodes[0] = 1;
+	}
+}
+
+bool safe_aligned_bind(void *ptr, MemoryNumaPolicy policy, size_t node) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+	INVARIANT(policy != MEMORY_NUMA_BIND || node < MEMORY_NUMA_MAX_NODES, ERR_LESS_EQUAL, "numa_node",
+	          "MEMORY_NUMA_MAX_NODES - 1", node, MEMORY_NUMA_MAX_NODES - 1);
+
+	if (policy == MEMORY_NUMA_DEFAULT) {
+		return true;
+	}
+
+	unsigned long nodes[SAFE_NUMA_MASK_WORDS] = {0};
+	if (policy == MEMORY_NUMA_BIND) {
+		nodes[node / SAFE_NUMA_WORD_BITS] = 1UL << (node % SAFE_NUMA_WORD_BITS);
+	} else {
+		safe_numa_allowed_nodes(nodes);
+	}
+
+	const Metadata *metadata = (const Metadata *)((uintptr_t)ptr - sizeof(Metadata));
+	const int mode = policy == MEMORY_NUMA_BIND ? SAFE_MPOL_BIND : SAFE_MPOL_INTERLEAVE;
+
+	return syscall(SYS_mbind, metadata->base, metadata->total_size, mode, nodes, MEMORY_NUMA_MAX_NODES + 1,
+	               SAFE_MPOL_MF_MOVE) == 0;
+}
+
+bool safe_aligned_unbind(void *ptr) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	const Metadata *metadata = (const Metadata *)((uintptr_t)ptr - sizeof(Metadata));
+	return syscall(SYS_mbind, metadata->base, metadata->total_size, SAFE_MPOL_DEFAULT, NULL, 0, 0) == 0;
+}
+
+void safe_aligned_prefault(void *ptr) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	const Metadata *metadata = (const Metadata *)((uintptr_t)ptr - sizeof(Metadata));
+	if (madvise(metadata->base, metadata->total_size, SAFE_MADV_POPULATE_WRITE) == 0) {
+		return;
+	}
+
+	// NOTE: An atomic no-op write faults the page in writable without a read fault first.
+	const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	for (size_t offset = 0; offset < metadata->total_size; offset += page_size) {
+		__atomic_fetch_or((unsigned char *)metadata->base + offset, 0, __ATOMIC_RELAXED);
+	}
+}
+
+bool safe_numa_node_allowed(size_t node) {
+	if (node >= MEMORY_NUMA_MAX_NODES) {
+		return false;
+	}
+
+	unsigned long nodes[SAFE_NUMA_MASK_WORDS];
+	safe_numa_allowed_nodes(nodes);
+	return (nodes[node / SAFE_NUMA_WORD_BITS] & (1UL << (node % SAFE_NUMA_WORD_BITS))) != 0;
+}
+
+size_t safe_numa_current_node(void) {
+	unsigned int cpu = 0;
+	unsigned int node = 0;
+	if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+		return 0;
+	}
+	return node;
+}
+
+size_t safe_aligned_header_size(const size_t alignment, const size_t header_size) {
+	return (header_size + sizeof(Metadata) + alignment - 1) & ~(alignment - 1);
+}
+
+void *safe_aligned_base(const void *const ptr) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	return ((const Metadata *)((uintptr_t)ptr - sizeof(Metadata)))->base;
+}
+
+MemoryPageBacking safe_aligned_page_backing(const void *const ptr) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	return ((const Metadata *)((uintptr_t)ptr - sizeof(Metadata)))->backing;
+}
+
+size_t safe_aligned_usable_size(const void *const ptr) {
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	const Metadata *metadata = (const Metadata *)((uintptr_t)ptr - sizeof(Metadata));
+	return (size_t)((uintptr_t)metadata->base + metadata->total_size - (uintptr_t)ptr);
 }
 
 void safe_free(void *ptr) {
@@ -47,10 +296,13 @@ void safe_aligned_free(void *ptr) {
 	INVARIANT(metadata->base != NULL, ERR_NULL_POINTER, "metadata->base");
 	INVARIANT(metadata->total_size > 0, ERR_VALUE_MIN, "metadata->total_size", 1, metadata->total_size);
 
-#ifdef DEBUG
-	memset(metadata->base, MEMORY_POISON_PATTERN, metadata->total_size);
-#else
-	memset(metadata->base, 0x0, metadata->total_size);
-#endif
-	munmap(metadata->base, metadata->total_size);
+	counted_munmap(metadata->base, metadata->total_size);
+}
+
+size_t safe_mmap_calls(void) {
+	return __atomic_load_n(&mmap_calls, __ATOMIC_RELAXED);
+}
+
+size_t safe_munmap_calls(void) {
+	return __atomic_load_n(&munmap_calls, __ATOMIC_RELAXED);
 }
@@ -0,0 +1,383 @@
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/allocation/block_recycler_internal.h"
+#include "anvil/memory/internal/allocation/block_spare_internal.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Adds a block of `capacity` bytes to the block counters of an arena. The counters are only
+ * written by the thread owning the arena, or the thread growing a CONCURRENT arena, but are
+ * read by `memory_arena_get_global_stats` on any thread.
+ */
+static inline void mapping_policy_count(MappingPolicy *const mapping, const size_t capacity) {
+	__atomic_fetch_add(&mapping->blocks, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&mapping->capacity, capacity, __ATOMIC_RELAXED);
+}
+
+/*
+ * Capacity the arena may still add before reaching its capacity limit, `SIZE_MAX` without one.
+ */
+static inline size_t mapping_policy_room(const MappingPolicy *const mapping) {
+	if (mapping->limit == 0) {
+		return SIZE_MAX;
+	}
+
+	const size_t used = __atomic_load_n(&mapping->capacity, __ATOMIC_RELAXED);
+	return used < mapping->limit ? mapping->limit - used : 0;
+}
+
+/*
+ * Creates a block as `memory_block_create` does, taking it from `spare` first if one is given
+ * and queuing the preparation of the next spare afterwards.
+ */
+static MemoryBlock *memory_block_create_from(const size_t capacity, const size_t alignment,
+                                             MappingPolicy *const mapping, BlockSpare *const spare) {
+	INVARIANT(capacity != 0, ERR_ZERO_CAPACITY, capacity);
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	const size_t block_capacity = memory_block_mapped_capacity(mapping, capacity, alignment);
+	INVARIANT(block_capacity != 0, ERR_ALLOCATION_TOO_LARGE, capacity, SIZE_MAX - HUGE_PAGE_SIZE);
+
+	// A spare was placed and prefaulted by the refill thread and only needs to be counted.
+	bool reused = false;
+	MemoryBlock *memory_block = spare ? block_spare_take(spare, block_capacity, alignment, &reused) : NULL;
+	if (memory_block) {
+		__atomic_fetch_add(reused ? &mapping->reuses : &mapping->maps, 1, __ATOMIC_RELAXED);
+	} else {
+		memory_block = block_recycler_acquire(block_capacity, alignment, mapping->huge_pages);
+		if (memory_block) {
+			__atomic_fetch_add(&mapping->reuses, 1, __ATOMIC_RELAXED);
+		} else {
+			void *memory = mapping->huge_pages
+			                   ? safe_aligned_alloc_huge(block_capacity, alignment, MEMORY_BLOCK_HEADER_SIZE)
+			                   : safe_aligned_alloc(block_capacity, alignment, MEMORY_BLOCK_HEADER_SIZE);
+
+			memory_block = &((MemoryBlockHeader *)safe_aligned_base(memory))->block;
+			memory_block->memory = memory;
+			memory_block->capacity = block_capacity;
+			memory_block->mapped = block_capacity;
+			memory_block->allocated = 0;
+			memory_block->dirty = 0;
+			memory_block->pinned = 0;
+			memory_block->placed = false;
+			memory_block->next = NULL;
+			__atomic_fetch_add(&mapping->maps, 1, __ATOMIC_RELAXED);
+		}
+
+		// Recycled blocks may have been placed for another arena, so the policy is applied or cleared.
+		if (mapping->numa_policy != MEMORY_NUMA_DEFAULT) {
+			safe_aligned_bind(memory_block->memory, mapping->numa_policy, mapping->numa_node);
+		} else if (memory_block->placed) {
+			safe_aligned_unbind(memory_block->memory);
+		}
+		memory_block->placed = mapping->numa_policy != MEMORY_NUMA_DEFAULT;
+		if (mapping->prefault) {
+			safe_aligned_prefault(memory_block->memory);
+		}
+	}
+
+	memory_block->sensitive = mapping->sensitive;
+	mapping_policy_count(mapping, memory_block->capacity);
+
+	const MemoryPageBacking backing = safe_aligned_page_backing(memory_block->memory);
+	if (backing < mapping->page_backing) {
+		mapping->page_backing = backing;
+	}
+
+	if (spare) {
+		const size_t next = memory_block_next_capacity(mapping, memory_block->capacity, 1, alignment);
+		if (next != 0) {
+			block_spare_refill(spare, next);
+		}
+	}
+
+	return memory_block;
+}
+
+size_t memory_block_mapped_capacity(const MappingPolicy *const mapping, const size_t capacity,
+                                    const size_t alignment) {
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	if (!mapping->huge_pages) {
+		return capacity;
+	}
+
+	/*
+	 * NOTE: Grow the capacity so the block together with its metadata fills whole huge pages,
+	 * otherwise the tail of the last huge page would be mapped but never handed out.
+	 */
+	const size_t header = safe_aligned_header_size(alignment, MEMORY_BLOCK_HEADER_SIZE);
+	if (capacity > SIZE_MAX - header - HUGE_PAGE_SIZE) {
+		return 0;
+	}
+	return ((capacity + header + (HUGE_PAGE_SIZE - 1)) & ~(HUGE_PAGE_SIZE - 1)) - header;
+}
+
+MemoryBlock *memory_block_create(const size_t capacity, const size_t alignment, MappingPolicy *const mapping) {
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	return memory_block_create_from(capacity, alignment, mapping, mapping->spare);
+}
+
+size_t memory_block_next_capacity(const MappingPolicy *const mapping, const size_t capacity, const size_t required,
+                                  const size_t granule) {
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+	INVARIANT(is_power_of_two(granule), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, granule);
+
+	size_t next = mapping->growth_chunk;
+	if (next == 0) {
+		const size_t factor = mapping->growth_factor ? mapping->growth_factor : 2;
+		next = capacity > SIZE_MAX / factor ? SIZE_MAX : capacity * factor;
+	}
+	if (mapping->max_block != 0 && next > mapping->max_block) {
+		next = mapping->max_block;
+	}
+
+	// No mapping can be larger than the address space the process can index.
+	const size_t largest = (size_t)PTRDIFF_MAX - (granule - 1);
+	if (required > largest) {
+		return 0;
+	}
+	const size_t exact = (required + (granule - 1)) & ~(granule - 1);
+
+	next = next > required ? next : required;
+	next = next <= largest ? (next + (granule - 1)) & ~(granule - 1) : exact;
+
+	// The limit applies to the capacity the block is mapped with, after huge page rounding.
+	const size_t room = mapping_policy_room(mapping);
+	const size_t mapped = memory_block_mapped_capacity(mapping, next, granule);
+	if (mapped == 0 || mapped > room) {
+		const size_t mapped_exact = memory_block_mapped_capacity(mapping, exact, granule);
+		next = mapped_exact != 0 && mapped_exact <= room ? exact : 0;
+	}
+
+	return next;
+}
+
+void *memory_block_alloc_large(MemoryBlock **const large_blocks, const size_t size, const size_t alignment,
+                               MappingPolicy *const mapping) {
+	INVARIANT(large_blocks, ERR_NULL_POINTER, "large_blocks");
+	INVARIANT(size != 0, ERR_ALLOC_SIZE_ZERO);
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	if (size > (size_t)PTRDIFF_MAX - (alignment - 1)) {
+		return NULL;
+	}
+	const size_t capacity = (size + (alignment - 1)) & ~(alignment - 1);
+	const size_t mapped = memory_block_mapped_capacity(mapping, capacity, alignment);
+	if (mapped == 0 || mapped > mapping_policy_room(mapping)) {
+		return NULL;
+	}
+
+	// Large blocks are sized by the allocation, not by the growth the spare was prepared for.
+	MemoryBlock *memory_block = memory_block_create_from(capacity, alignment, mapping, NULL);
+	memory_block->allocated = size;
+	memory_block->next = *large_blocks;
+	*large_blocks = memory_block;
+
+	return memory_block->memory;
+}
+
+MemoryBlock *memory_block_reserve(const size_t capacity, const size_t alignment, MappingPolicy *const mapping) {
+	INVARIANT(capacity != 0, ERR_ZERO_CAPACITY, capacity);
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	void *memory = safe_aligned_reserve(capacity, alignment, MEMORY_BLOCK_HEADER_SIZE, mapping->huge_pages);
+
+	MemoryBlock *memory_block = &((MemoryBlockHeader *)safe_aligned_base(memory))->block;
+	memory_block->memory = memory;
+	memory_block->capacity = capacity;
+	memory_block->mapped = capacity;
+	memory_block->allocated = 0;
+	memory_block->dirty = 0;
+	memory_block->pinned = 0;
+	memory_block->next = NULL;
+	memory_block->sensitive = mapping->sensitive;
+	memory_block->placed = mapping->numa_policy != MEMORY_NUMA_DEFAULT;
+	__atomic_fetch_add(&mapping->maps, 1, __ATOMIC_RELAXED);
+	mapping_policy_count(mapping, capacity);
+	safe_aligned_bind(memory, mapping->numa_policy, mapping->numa_node);
+
+	const MemoryPageBacking backing = safe_aligned_page_backing(memory);
+	if (backing < mapping->page_backing) {
+		mapping->page_backing = backing;
+	}
+
+	return memory_block;
+}
+
+/*
+ * Wipes the used bytes of a sensitive block with a store the compiler can not drop, so the
+ * data is gone before the block is recycled or unmapped.
+ */
+static void memory_block_wipe(MemoryBlock *const memory_block) {
+	if (!memory_block->sensitive) {
+		return;
+	}
+
+	explicit_bzero(memory_block->memory, memory_block_touched(memory_block));
+	memory_block->allocated = 0;
+	memory_block->dirty = 0;
+	memory_block->sensitive = false;
+}
+
+bool memory_block_destroy(MemoryBlock *const memory_block) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	memory_block_wipe(memory_block);
+	if (block_recycler_release(memory_block)) {
+		return false;
+	}
+	memory_block_unmap(memory_block);
+	return true;
+}
+
+void memory_block_chain_release(MemoryBlock *const memory_block, MappingPolicy *const mapping) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
+		__atomic_fetch_sub(&mapping->blocks, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&mapping->capacity, current->capacity, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&mapping->releases, 1, __ATOMIC_RELAXED);
+		if (memory_block_destroy(current)) {
+			__atomic_fetch_add(&mapping->unmaps, 1, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+void memory_block_chain_reset(MemoryBlock *const memory_block, ResetPolicy *const policy,
+                              MappingPolicy *const mapping) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+	INVARIANT(policy, ERR_NULL_POINTER, "policy");
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	MemoryBlock *last_kept = memory_block;
+	MemoryBlock *before_last_kept = NULL;
+	size_t kept_blocks = 0;
+	size_t kept_bytes = 0;
+
+	for (MemoryBlock *current = memory_block->next; current; current = current->next) {
+		if (kept_blocks == policy->max_blocks ||
+		    (policy->max_bytes != 0 && current->capacity > policy->max_bytes - kept_bytes)) {
+			break;
+		}
+		kept_blocks++;
+		kept_bytes += current->capacity;
+		before_last_kept = last_kept;
+		last_kept = current;
+	}
+
+	if (last_kept->next) {
+		memory_block_chain_release(last_kept->next, mapping);
+		last_kept->next = NULL;
+	}
+
+	if (policy->decay != 0 && before_last_kept) {
+		policy->idle_resets = last_kept->allocated == 0 ? policy->idle_resets + 1 : 0;
+		if (policy->idle_resets >= policy->decay) {
+			before_last_kept->next = NULL;
+			memory_block_chain_release(last_kept, mapping);
+			policy->idle_resets = 0;
+		}
+	}
+
+	for (MemoryBlock *current = memory_block; current; current = current->next) {
+		memory_block_rewind(current, 0, policy);
+	}
+}
+
+void memory_block_rewind(MemoryBlock *const memory_block, const size_t offset, const ResetPolicy *const policy) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+	INVARIANT(policy, ERR_NULL_POINTER, "policy");
+
+	const size_t used =
+	    memory_block->allocated < memory_block->capacity ? memory_block->allocated : memory_block->capacity;
+	if (offset < used) {
+		if (policy->zeroing == MEMORY_RESET_ZERO_NONE) {
+			memory_block->dirty = used > memory_block->dirty ? used : memory_block->dirty;
+		} else if (offset == 0) {
+			memory_block_zero(memory_block, used, policy->zeroing, policy->release_threshold);
+		} else {
+			memset((char *)memory_block->memory + offset, 0x0, used - offset);
+		}
+	}
+
+	memory_block->allocated = offset;
+	memory_block->pinned = offset;
+}
+
+void memory_block_zero(MemoryBlock *const memory_block, const size_t size, const MemoryResetZeroing zeroing,
+                       const size_t release_threshold) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	if (size == 0 || zeroing == MEMORY_RESET_ZERO_NONE) {
+		return;
+	}
+
+	if (zeroing == MEMORY_RESET_ZERO_RELEASE && size >= release_threshold) {
+		const size_t granule = safe_aligned_page_backing(memory_block->memory) == MEMORY_PAGES_DEFAULT
+		                           ? (size_t)sysconf(_SC_PAGESIZE)
+		                           : HUGE_PAGE_SIZE;
+		const uintptr_t start = (uintptr_t)memory_block->memory;
+		const uintptr_t end = start + size;
+		const uintptr_t first = (start + (granule - 1)) & ~(uintptr_t)(granule - 1);
+		const uintptr_t last = end & ~(uintptr_t)(granule - 1);
+
+		if (first < last && madvise((void *)first, last - first, MADV_DONTNEED) == 0) {
+			memset((void *)start, 0x0, first - start);
+			memset((void *)last, 0x0, end - last);
+			return;
+		}
+	}
+
+	memset(memory_block->memory, 0x0, size);
+}
+
+void memory_block_unmap(MemoryBlock *const memory_block) {
+	if (!memory_block) {
+		return;
+	}
+
+	memory_block_wipe(memory_block);
+	safe_aligned_free(memory_block->memory);
+}
+
+MemoryArena *memory_block_arena(MemoryBlock *const memory_block) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	return &((MemoryBlockHeader *)memory_block)->arena;
+}
+
+bool memory_block_resize_last(MemoryBlock *const memory_block, void *const ptr, const size_t old_size,
+                              const size_t new_size) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+	INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	const uintptr_t memory = (uintptr_t)memory_block->memory;
+	if ((uintptr_t)ptr < memory || (uintptr_t)ptr - memory > memory_block->allocated) {
+		return false;
+	}
+
+	const size_t offset = (size_t)((uintptr_t)ptr - memory);
+	if (memory_block->allocated - offset != old_size || new_size > memory_block->capacity - offset ||
+	    offset < memory_block->pinned) {
+		return false;
+	}
+
+	// Reset only clears memory below the allocation offset, so a released tail is cleared now.
+	if (new_size < old_size) {
+		memset((char *)ptr + new_size, 0x0, old_size - new_size);
+	}
+
+	memory_block->allocated = offset + new_size;
+	return true;
+}
@@ -0,0 +1,192 @@
+#include "anvil/memory/internal/allocators/concurrent_allocator_internal.h"
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*****************************************************************************************************
+ *					Concurrent Allocator
+ * ***************************************************************************************************/
+
+void concurrent_free(MemoryBlock *const memory_block) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
+		memory_block_destroy(current);
+	}
+}
+
+void concurrent_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	memory_block_chain_reset(memory_block, policy, mapping);
+}
+
+/*
+ * Appends a new tail block after `exhausted` unless another thread already replaced it
+ * while this one waited for the growth lock. Threads that lose the race simply retry their
+ * claim on whatever block is current once the lock is released. Returns false if the
+ * capacity limit of the arena leaves no room for the new block.
+ */
+static bool concurrent_grow(MemoryArena *const arena, MemoryBlock *const exhausted, const size_t claim) {
+	ConcurrentAllocatorState *state = &arena->state.concurrentAllocatorState;
+
+	while (__atomic_test_and_set(&state->growth_lock, __ATOMIC_ACQUIRE)) {
+		while (__atomic_load_n(&state->growth_lock, __ATOMIC_RELAXED)) {
+			sched_yield();
+		}
+	}
+
+	bool grown = true;
+	if (__atomic_load_n(&state->current, __ATOMIC_RELAXED) == exhausted) {
+		MemoryBlock *new_block = exhausted->next;
+
+		if (!new_block) {
+			const size_t new_capacity =
+			    memory_block_next_capacity(&arena->mapping_policy, exhausted->capacity, claim,
+			                               arena->alignment);
+			if (new_capacity != 0) {
+				new_block = memory_block_create(new_capacity, arena->alignment, &arena->mapping_policy);
+				exhausted->next = new_block;
+			}
+		}
+
+		if (new_block) {
+			__atomic_store_n(&state->current, new_block, __ATOMIC_RELEASE);
+		} else {
+			grown = false;
+		}
+	}
+
+	__atomic_clear(&state->growth_lock, __ATOMIC_RELEASE);
+	return grown;
+}
+
+void *concurrent_alloc(MemoryArena **const arena, const size_t allocation_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	PARANOID_INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO,
+	                   (*arena)->alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	HOT_INVARIANT(allocation_size <= SIZE_MAX - (*arena)->alignment, ERR_ALLOCATION_TOO_LARGE, allocation_size,
+	              SIZE_MAX - (*arena)->alignment);
+
+	ConcurrentAllocatorState *state = &(*arena)->state.concurrentAllocatorState;
+	const size_t alignment = (*arena)->alignment;
+	const size_t claim = (allocation_size + (alignment - 1)) & ~(alignment - 1);
+
+	while (1) {
+		MemoryBlock *current_block = __atomic_load_n(&state->current, __ATOMIC_ACQUIRE);
+		size_t offset = __atomic_fetch_add(&current_block->allocated, claim, __ATOMIC_RELAXED);
+
+		if (likely(offset <= current_block->capacity && claim <= current_block->capacity - offset)) {
+			return (void *)((uintptr_t)current_block->memory + offset);
+		}
+
+		if (unlikely(!concurrent_grow(*arena, current_block, claim))) {
+			return NULL;
+		}
+	}
+	__builtin_unreachable();
+}
+
+void *concurrent_alloc_aligned(MemoryArena **const arena, const size_t allocation_size, const size_t alignment) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(alignment >= (*arena)->alignment, ERR_ALIGNMENT_TOO_SMALL, (*arena)->alignment, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	HOT_INVARIANT(allocation_size <= SIZE_MAX - 2 * alignment, ERR_ALLOCATION_TOO_LARGE, allocation_size,
+	              SIZE_MAX - 2 * alignment);
+
+	ConcurrentAllocatorState *state = &(*arena)->state.concurrentAllocatorState;
+	const size_t arena_alignment = (*arena)->alignment;
+	const size_t claim =
+	    ((allocation_size + (arena_alignment - 1)) & ~(arena_alignment - 1)) + (alignment - arena_alignment);
+
+	while (1) {
+		MemoryBlock *current_block = __atomic_load_n(&state->current, __ATOMIC_ACQUIRE);
+		size_t offset = __atomic_fetch_add(&current_block->allocated, claim, __ATOMIC_RELAXED);
+
+		if (likely(offset <= current_block->capacity && claim <= current_block->capacity - offset)) {
+			const uintptr_t start = (uintptr_t)current_block->memory + offset;
+			return (void *)((start + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+		}
+
+		if (unlikely(!concurrent_grow(*arena, current_block, claim))) {
+			return NULL;
+		}
+	}
+	__builtin_unreachable();
+}
+
+bool concurrent_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	ConcurrentAllocatorState *state = &(*arena)->state.concurrentAllocatorState;
+	MemoryBlock *current_block = __atomic_load_n(&state->current, __ATOMIC_ACQUIRE);
+	const size_t alignment = (*arena)->alignment;
+	const uintptr_t memory = (uintptr_t)current_block->memory;
+
+	if ((uintptr_t)ptr < memory || (uintptr_t)ptr - memory > current_block->capacity ||
+	    old_size > SIZE_MAX - alignment || new_size > SIZE_MAX - alignment) {
+		return false;
+	}
+
+	const size_t offset = (size_t)((uintptr_t)ptr - memory);
+	const size_t old_claim = (old_size + (alignment - 1)) & ~(alignment - 1);
+	const size_t new_claim = (new_size + (alignment - 1)) & ~(alignment - 1);
+	if (old_claim > current_block->capacity - offset || new_claim > current_block->capacity - offset ||
+	    offset < current_block->pinned) {
+		return false;
+	}
+
+	/*
+	 * NOTE: A released tail can be claimed by another thread as soon as the swap succeeds, so it
+	 * is zeroed before. The bytes belong to the shrinking caller either way.
+	 */
+	if (new_claim < old_claim) {
+		memset((char *)ptr + new_claim, 0x0, old_claim - new_claim);
+	}
+
+	size_t expected = offset + old_claim;
+	return __atomic_compare_exchange_n(&current_block->allocated, &expected, offset + new_claim, false,
+	                                   __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+bool concurrent_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	/*
+	 * NOTE: Like the linear allocator this one grows on demand, so an allocation can always be
+	 * satisfied unless neither the current block nor a block kept past it by a reset holds it
+	 * and the capacity limit leaves no room for a new block. Running out of system memory is an
+	 * invariant failure. Claims may push the offset past the capacity.
+	 */
+	if (allocation_size > SIZE_MAX - arena->alignment) {
+		return false;
+	}
+
+	const size_t claim = (allocation_size + (arena->alignment - 1)) & ~(arena->alignment - 1);
+	const MemoryBlock *current = __atomic_load_n(&arena->state.concurrentAllocatorState.current, __ATOMIC_ACQUIRE);
+	while (1) {
+		const size_t allocated = __atomic_load_n(&current->allocated, __ATOMIC_RELAXED);
+		if (allocated <= current->capacity && claim <= current->capacity - allocated) {
+			return true;
+		}
+		if (!current->next) {
+			return memory_block_next_capacity(&arena->mapping_policy, current->capacity, claim,
+			                                  arena->alignment) != 0;
+		}
+		current = current->next;
+	}
+}
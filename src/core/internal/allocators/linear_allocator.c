@@ -1,9 +1,11 @@
 #include "anvil/memory/arena.h"
 #include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
 #include "anvil/memory/internal/allocators/linear_allocator_internal.h"
 #include "anvil/memory/internal/error/error_templates.h"
 #include "anvil/memory/internal/utility_internal.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -16,69 +18,174 @@ void linear_free(MemoryBlock *const memory_block) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory");
 
 	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
-		safe_aligned_free(current->memory);
-		free(current);
+		memory_block_destroy(current);
 	}
 }
 
-void linear_reset(MemoryBlock *const memory_block) {
+void linear_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory");
 
-	memset(memory_block->memory, 0x0, memory_block->allocated);
-	memory_block->allocated = 0;
-	if (memory_block->next) {
-		linear_free(memory_block->next);
-		memory_block->next = NULL;
+	memory_block_chain_reset(memory_block, policy, mapping);
+}
+
+/*
+ * Bumps `allocation_size` bytes at `alignment` out of a single block, or returns NULL if the
+ * block does not have enough room left.
+ */
+static inline void *linear_block_alloc(MemoryBlock *const memory_block, const size_t allocation_size,
+                                       const size_t alignment) {
+	uintptr_t base = (uintptr_t)memory_block->memory;
+	uintptr_t current = base + memory_block->allocated;
+	uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+	size_t offset = aligned - current;
+	size_t total_size = allocation_size + offset;
+
+	if (total_size > memory_block->capacity - memory_block->allocated) {
+		return NULL;
 	}
+
+	memory_block->allocated += total_size;
+	return (void *)aligned;
 }
 
-void *linear_alloc(MemoryArena **const arena, const size_t allocation_size) {
-	INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
-	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
-	INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
-	INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, (*arena)->alignment);
-	INVARIANT((*arena)->alignment >= _Alignof(max_align_t), ERR_ALIGNMENT_TOO_SMALL, (*arena)->alignment,
-	          _Alignof(max_align_t));
-	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+/*
+ * Whether `allocation_size` bytes at `alignment` fit in the room left in a single block.
+ */
+static inline bool linear_block_fits(const MemoryBlock *const memory_block, const size_t allocation_size,
+                                     const size_t alignment) {
+	const uintptr_t current = (uintptr_t)memory_block->memory + memory_block->allocated;
+	const size_t offset = (size_t)(((current + (alignment - 1)) & ~(uintptr_t)(alignment - 1)) - current);
+	const size_t available = memory_block->capacity - memory_block->allocated;
 
-	MemoryBlock *current_block = (*arena)->memory_block;
-	const size_t alignment = (*arena)->alignment;
+	return offset <= available && allocation_size <= available - offset;
+}
 
-	while (1) {
-		uintptr_t base = (uintptr_t)current_block->memory;
-		uintptr_t current = base + current_block->allocated;
+/*
+ * Returns the block from `memory_block` up to the cursor `last` with the least room left that
+ * can still hold the allocation, or NULL. Blocks retained past the cursor are only reached by
+ * moving the cursor, so everything allocated before a checkpoint lies at or before its position.
+ */
+static MemoryBlock *linear_best_fit(MemoryBlock *const memory_block, const MemoryBlock *const last,
+                                    const size_t allocation_size, const size_t alignment) {
+	MemoryBlock *best_block = NULL;
+	size_t best_remaining = SIZE_MAX;
+
+	for (MemoryBlock *current_block = memory_block; current_block != last->next;
+	     current_block = current_block->next) {
+		uintptr_t current = (uintptr_t)current_block->memory + current_block->allocated;
 		uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
-		size_t offset = aligned - current;
-		size_t total_size = allocation_size + offset;
+		size_t total_size = allocation_size + (aligned - current);
+		size_t available = current_block->capacity - current_block->allocated;
 
-		if (total_size <= current_block->capacity - current_block->allocated) {
-			current_block->allocated += total_size;
-			return (void *)aligned;
+		if (total_size <= available && available - total_size < best_remaining) {
+			best_block = current_block;
+			best_remaining = available - total_size;
 		}
+	}
+	return best_block;
+}
 
-		if (!current_block->next) {
-			current_block->next = malloc(sizeof(MemoryBlock));
-			INVARIANT(current_block->next, ERR_OUT_OF_MEMORY, sizeof(MemoryBlock));
+/*
+ * Shared body of `linear_alloc` and `linear_alloc_aligned`. Inlined into both, so the arena
+ * alignment of a plain allocation costs no more than it did before aligned allocations.
+ */
+static inline __attribute__((always_inline)) void *linear_alloc_at(MemoryArena **const arena,
+                                                                   const size_t allocation_size,
+                                                                   const size_t alignment) {
+	LinearAllocatorState *state = &(*arena)->state.linearAllocatorState;
+	MemoryBlock *current_block = state->cursor;
 
-			current_block->next->memory = safe_aligned_alloc((current_block->capacity << 1), alignment);
-			current_block->next->allocated = 0;
-			current_block->next->capacity = (current_block->capacity << 1);
-			current_block->next->next = NULL;
+	void *result = linear_block_alloc(current_block, allocation_size, alignment);
+	if (likely(result)) {
+		return result;
+	}
+
+	if (state->best_fit) {
+		MemoryBlock *best_block =
+		    linear_best_fit((*arena)->memory_block, current_block, allocation_size, alignment);
+		if (best_block) {
+			return linear_block_alloc(best_block, allocation_size, alignment);
+		}
+	}
+
+	/*
+	 * NOTE: Large allocations get a block of their own instead of moving the cursor, so the
+	 * chain keeps growing from the size of its own blocks and retained blocks stay available.
+	 */
+	MappingPolicy *const mapping = &(*arena)->mapping_policy;
+	if (mapping->large_threshold != 0 && allocation_size > mapping->large_threshold) {
+		return memory_block_alloc_large(&(*arena)->large_blocks, allocation_size, alignment, mapping);
+	}
+
+	while (1) {
+		if (!current_block->next) {
+			const size_t capacity =
+			    memory_block_next_capacity(mapping, current_block->capacity, allocation_size, alignment);
+			if (unlikely(capacity == 0)) {
+				return NULL;
+			}
+			current_block->next = memory_block_create(capacity, alignment, mapping);
 		}
 
 		current_block = current_block->next;
+		state->cursor = current_block;
+
+		result = linear_block_alloc(current_block, allocation_size, alignment);
+		if (result) {
+			return result;
+		}
 	}
 	__builtin_unreachable();
 }
 
+void *linear_alloc(MemoryArena **const arena, const size_t allocation_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	PARANOID_INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
+	PARANOID_INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO,
+	                   (*arena)->alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	return linear_alloc_at(arena, allocation_size, (*arena)->alignment);
+}
+
+void *linear_alloc_aligned(MemoryArena **const arena, const size_t allocation_size, const size_t alignment) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	return linear_alloc_at(arena, allocation_size, alignment);
+}
+
 bool linear_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
 	INVARIANT(arena, ERR_NULL_POINTER, "arena");
 	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
 
 	/*
-	 * NOTE:(UniquesKernel) Because the memory allocation is dynamic it should always return true
-	 * when asked if the arena can handle an allocation. If the system runs out of memory because of
-	 * a malloc failure, then an invariant issue should cause a system failure.
+	 * NOTE: Blocks are created on demand, so an allocation only fails when no block it can reach
+	 * holds it and the capacity limit leaves no room for a block that does. The blocks are tried
+	 * in the order `linear_alloc_at` tries them. Running out of system memory is an invariant
+	 * failure.
 	 */
-	return true;
+	const LinearAllocatorState *state = &arena->state.linearAllocatorState;
+	const MappingPolicy *const mapping = &arena->mapping_policy;
+	const size_t alignment = arena->alignment;
+	if (linear_block_fits(state->cursor, allocation_size, alignment) ||
+	    (state->best_fit && linear_best_fit(arena->memory_block, state->cursor, allocation_size, alignment))) {
+		return true;
+	}
+
+	// A large allocation is mapped on its own, which needs the same room as a block holding it.
+	const MemoryBlock *current_block = state->cursor;
+	if (mapping->large_threshold == 0 || allocation_size <= mapping->large_threshold) {
+		while (current_block->next) {
+			current_block = current_block->next;
+			if (linear_block_fits(current_block, allocation_size, alignment)) {
+				return true;
+			}
+		}
+	}
+
+	return memory_block_next_capacity(mapping, current_block->capacity, allocation_size, alignment) != 0;
 }
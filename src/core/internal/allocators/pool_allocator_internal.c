@@ -1,10 +1,12 @@
 #include "anvil/memory/internal/allocators/pool_allocator_internal.h"
 #include "anvil/memory/arena.h"
 #include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
 #include "anvil/memory/internal/arena_internal.h"
 #include "anvil/memory/internal/error/error_templates.h"
 #include "anvil/memory/internal/utility_internal.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,67 +14,77 @@ void pool_free(MemoryBlock *const memory_block) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
 
 	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
-		safe_aligned_free(current->memory);
-		free(current);
+		memory_block_destroy(current);
 	}
 }
 
-void pool_reset(MemoryBlock *const memory_block) {
+void pool_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
 
-	memset(memory_block->memory, 0x0, memory_block->allocated);
-	memory_block->allocated = 0;
-	if (memory_block->next) {
-		pool_free(memory_block->next);
-		memory_block->next = NULL;
-	}
+	memory_block_chain_reset(memory_block, policy, mapping);
 }
 
 void *pool_alloc(MemoryArena **const arena, const size_t allocation_size) {
-	INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
-	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
-	INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
-	INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, (*arena)->alignment);
-	INVARIANT((*arena)->alignment >= _Alignof(max_align_t), ERR_ALIGNMENT_TOO_SMALL, (*arena)->alignment,
-	          _Alignof(max_align_t));
-	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	PARANOID_INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
+	PARANOID_INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO,
+	                   (*arena)->alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
 
-	MemoryBlock *current_block = (*arena)->memory_block;
-	size_t alignment = (*arena)->alignment;
-	size_t pool_size = (*arena)->state.poolAllocatorState.pool_size;
+	PoolAllocatorState *state = &(*arena)->state.poolAllocatorState;
+	const size_t slot_size = state->slot_size;
 
-	size_t num_pools = allocation_size / pool_size;
-	size_t pool_aligned_size = num_pools * pool_size;
-
-	if (pool_aligned_size < allocation_size) {
-		pool_aligned_size += pool_size;
+	if (unlikely(allocation_size > slot_size)) {
+		return NULL;
 	}
 
-	while (1) {
-		uintptr_t base = (uintptr_t)current_block->memory;
-		uintptr_t current = base + current_block->allocated;
-		uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
-		size_t offset = aligned - current;
-		size_t total_size = pool_aligned_size + offset;
+	void *slot = state->free_list;
+	if (slot) {
+		memcpy(&state->free_list, slot, sizeof(void *));
+		memset(slot, 0x0, sizeof(void *));
+		return slot;
+	}
 
-		if (total_size <= current_block->capacity - current_block->allocated) {
-			current_block->allocated += total_size;
-			return (void *)aligned;
+	MemoryBlock *current_block = state->cursor;
+	if (unlikely(slot_size > current_block->capacity - current_block->allocated)) {
+		if (!current_block->next) {
+			MappingPolicy *const mapping = &(*arena)->mapping_policy;
+			// Large slots are mapped one at a time, freeing one links it into the free list as usual.
+			if (mapping->large_threshold != 0 && slot_size > mapping->large_threshold) {
+				return memory_block_alloc_large(&(*arena)->large_blocks, slot_size, (*arena)->alignment,
+				                                mapping);
+			}
+			const size_t new_capacity = memory_block_next_capacity(mapping, current_block->capacity,
+			                                                       slot_size, (*arena)->alignment);
+			if (unlikely(new_capacity == 0)) {
+				return NULL;
+			}
+			current_block->next = memory_block_create(new_capacity, (*arena)->alignment, mapping);
 		}
+		current_block = current_block->next;
+		state->cursor = current_block;
+	}
 
-		if (!current_block->next) {
-			current_block->next = malloc(sizeof(MemoryBlock));
-			INVARIANT(current_block->next, ERR_OUT_OF_MEMORY, sizeof(MemoryBlock));
+	slot = (char *)current_block->memory + current_block->allocated;
+	current_block->allocated += slot_size;
 
-			current_block->next->memory = safe_aligned_alloc((current_block->capacity << 1), alignment);
-			current_block->next->allocated = 0;
-			current_block->next->capacity = (current_block->capacity << 1);
-			current_block->next->next = NULL;
-		}
+	return slot;
+}
 
-		current_block = current_block->next;
+void pool_dealloc(MemoryArena **const arena, void *const ptr) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+	HOT_INVARIANT(((uintptr_t)ptr & ((*arena)->alignment - 1)) == 0, ERR_INVALID_STATE, "ptr", "slot aligned",
+	              "misaligned");
+
+	PoolAllocatorState *state = &(*arena)->state.poolAllocatorState;
+	// Arenas that do not zero on reset hand freed slots out as they were left, like memory past a reset.
+	if ((*arena)->reset_policy.zeroing != MEMORY_RESET_ZERO_NONE) {
+		memset(ptr, 0x0, state->slot_size);
 	}
-	__builtin_unreachable();
+	memcpy(ptr, &state->free_list, sizeof(void *));
+	state->free_list = ptr;
 }
 
 bool pool_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
@@ -80,5 +92,14 @@ bool pool_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
 	INVARIANT(arena->memory_block, ERR_NULL_POINTER, "arena->memory_block");
 	INVARIANT(is_power_of_two(arena->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, arena->alignment);
 	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
-	return true;
+
+	const PoolAllocatorState *state = &arena->state.poolAllocatorState;
+	if (allocation_size > state->slot_size) {
+		return false;
+	}
+
+	return state->free_list || state->slot_size <= state->cursor->capacity - state->cursor->allocated ||
+	       state->cursor->next ||
+	       memory_block_next_capacity(&arena->mapping_policy, state->cursor->capacity, state->slot_size,
+	                                  arena->alignment) != 0;
 }
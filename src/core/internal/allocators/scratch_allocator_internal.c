@@ -1,6 +1,7 @@
 #include "anvil/memory/internal/allocators/scratch_allocator_internal.h"
 #include "anvil/memory/arena.h"
 #include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
 #include "anvil/memory/internal/arena_internal.h"
 #include "anvil/memory/internal/error/error_templates.h"
 #include "anvil/memory/internal/utility_internal.h"
@@ -18,46 +19,57 @@
 void scratch_free(MemoryBlock *const memory_block) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory");
 	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
-		safe_aligned_free(current->memory);
-		free(current);
+		memory_block_destroy(current);
 	}
 }
 
-void scratch_reset(MemoryBlock *const memory_block) {
+void scratch_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory");
 
-	memset(memory_block->memory, 0x0, memory_block->allocated);
-	memory_block->allocated = 0;
-	if (memory_block->next) {
-		scratch_free(memory_block->next);
-		memory_block->next = NULL;
-	}
+	memory_block_chain_reset(memory_block, policy, mapping);
 }
 
-void *scratch_alloc(MemoryArena **const arena, const size_t allocation_size) {
-	INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
-	INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
-	INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
-	INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, (*arena)->alignment);
-	INVARIANT((*arena)->alignment >= _Alignof(max_align_t), ERR_ALIGNMENT_TOO_SMALL, (*arena)->alignment,
-	          _Alignof(max_align_t));
-	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
-
-	uintptr_t base = (uintptr_t)(*arena)->memory_block->memory;
-	uintptr_t current = base + (*arena)->memory_block->allocated;
-	uintptr_t aligned = (current + ((*arena)->alignment - 1)) & ~(uintptr_t)((*arena)->alignment - 1);
+/*
+ * Bumps `allocation_size` bytes at `alignment` out of the head block, or returns NULL if it
+ * does not have enough room left.
+ */
+static inline __attribute__((always_inline)) void *scratch_alloc_at(MemoryBlock *const memory_block,
+                                                                    const size_t allocation_size,
+                                                                    const size_t alignment) {
+	uintptr_t base = (uintptr_t)memory_block->memory;
+	uintptr_t current = base + memory_block->allocated;
+	uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
 	size_t offset = aligned - current;
+	size_t available = memory_block->capacity - memory_block->allocated;
 
-	size_t total_size = allocation_size + offset;
-
-	if (total_size > (*arena)->memory_block->capacity - (*arena)->memory_block->allocated) {
+	if (offset > available || allocation_size > available - offset) {
 		return NULL;
 	}
 
-	(*arena)->memory_block->allocated += total_size;
+	memory_block->allocated += allocation_size + offset;
 	return (void *)aligned;
 }
 
+void *scratch_alloc(MemoryArena **const arena, const size_t allocation_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	PARANOID_INVARIANT((*arena)->memory_block->memory, ERR_NULL_POINTER, "arena->memory_block->memory");
+	PARANOID_INVARIANT(is_power_of_two((*arena)->alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO,
+	                   (*arena)->alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	return scratch_alloc_at((*arena)->memory_block, allocation_size, (*arena)->alignment);
+}
+
+void *scratch_alloc_aligned(MemoryArena **const arena, const size_t allocation_size, const size_t alignment) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	return scratch_alloc_at((*arena)->memory_block, allocation_size, alignment);
+}
+
 bool scratch_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
 	INVARIANT(arena, ERR_NULL_POINTER, "arena");
 	INVARIANT(arena->memory_block, ERR_NULL_POINTER, "arena->memory_block");
@@ -0,0 +1,321 @@
+#include "anvil/memory/internal/allocators/size_class_allocator_internal.h"
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*****************************************************************************************************
+ *					Size Class Allocator
+ * ***************************************************************************************************/
+
+/*
+ * Classes are 16 bytes apart up to 128 bytes, followed by four classes per doubling. The
+ * index of a size is taken from its position within its doubling, so no table walk is needed.
+ */
+static inline size_t size_class_index(const size_t size) {
+	if (size <= 128) {
+		return (size - 1) >> 4;
+	}
+
+	const size_t log = (size_t)(63 - __builtin_clzll((unsigned long long)(size - 1)));
+	return 8 + ((log - 7) << 2) + ((size - 1) >> (log - 2)) - 4;
+}
+
+static inline size_t size_class_slot_size(const size_t index) {
+	if (index < 8) {
+		return (index + 1) << 4;
+	}
+
+	const size_t doubling = (index - 8) >> 2;
+	return ((size_t)128 << doubling) + (((index - 8) & 3) + 1) * ((size_t)32 << doubling);
+}
+
+SizeClassTable *size_class_table_create(const size_t alignment) {
+	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	INVARIANT(alignment < SIZE_CLASS_RUN_SIZE, ERR_LESS_THAN, "alignment", "SIZE_CLASS_RUN_SIZE", alignment,
+	          SIZE_CLASS_RUN_SIZE);
+
+	SizeClassTable *table = calloc(1, sizeof(SizeClassTable));
+	INVARIANT(table, ERR_OUT_OF_MEMORY, sizeof(SizeClassTable));
+
+	for (size_t index = 0; index < MEMORY_SIZE_CLASS_COUNT; index++) {
+		table->classes[index].slot_size = size_class_slot_size(index);
+	}
+	table->data_offset = (sizeof(SizeClassRunHeader) + (alignment - 1)) & ~(alignment - 1);
+
+	return table;
+}
+
+void size_class_free(MemoryBlock *const memory_block) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
+		memory_block_destroy(current);
+	}
+}
+
+void size_class_reset(MemoryBlock *const memory_block, SizeClassTable *const table, ResetPolicy *const policy,
+                      MappingPolicy *const mapping) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+	INVARIANT(table, ERR_NULL_POINTER, "table");
+
+	memory_block_chain_reset(memory_block, policy, mapping);
+
+	for (size_t index = 0; index < MEMORY_SIZE_CLASS_COUNT; index++) {
+		SizeClass *size_class = &table->classes[index];
+		size_class->free_list = NULL;
+		size_class->bump = NULL;
+		size_class->end = NULL;
+		size_class->runs = 0;
+		size_class->slots = 0;
+		size_class->live = 0;
+	}
+	table->large_bump = NULL;
+	table->large_end = NULL;
+}
+
+/*
+ * Carves `span` bytes, a multiple of the run size, from the active block and stamps the run
+ * header. Blocks are aligned to the run size and only ever carved in whole runs, so every
+ * run starts on a run boundary. Returns NULL if the capacity limit prevents the arena from
+ * growing.
+ */
+static char *size_class_carve(MemoryArena *const arena, const size_t span, const size_t size_class) {
+	SizeClassAllocatorState *state = &arena->state.sizeClassAllocatorState;
+	MemoryBlock *current_block = state->cursor;
+
+	while (span > current_block->capacity - current_block->allocated) {
+		if (!current_block->next) {
+			const size_t new_capacity = memory_block_next_capacity(
+			    &arena->mapping_policy, current_block->capacity, span, SIZE_CLASS_RUN_SIZE);
+			if (unlikely(new_capacity == 0)) {
+				return NULL;
+			}
+			current_block->next =
+			    memory_block_create(new_capacity, SIZE_CLASS_RUN_SIZE, &arena->mapping_policy);
+		}
+		current_block = current_block->next;
+		state->cursor = current_block;
+	}
+
+	char *run = (char *)current_block->memory + current_block->allocated;
+	current_block->allocated += span;
+	((SizeClassRunHeader *)run)->size_class = size_class;
+
+	return run;
+}
+
+/*
+ * Bumps a large allocation at `alignment` out of the current large run, or carves a new run
+ * for it. Large runs start with their header, so the first allocation of a run is placed at
+ * the data offset rounded up to the alignment.
+ */
+static void *size_class_alloc_large(MemoryArena *const arena, SizeClassTable *const table, const size_t size,
+                                    const size_t alignment) {
+	const uintptr_t bump = ((uintptr_t)table->large_bump + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+	if (bump <= (uintptr_t)table->large_end && size <= (size_t)((uintptr_t)table->large_end - bump)) {
+		table->large_bump = (char *)bump + size;
+		return (void *)bump;
+	}
+
+	const size_t offset = (table->data_offset + (alignment - 1)) & ~(alignment - 1);
+	const size_t span = (offset + size + (SIZE_CLASS_RUN_SIZE - 1)) & ~(SIZE_CLASS_RUN_SIZE - 1);
+	char *run = size_class_carve(arena, span, SIZE_CLASS_LARGE);
+	if (unlikely(!run)) {
+		return NULL;
+	}
+
+	if (span == SIZE_CLASS_RUN_SIZE) {
+		table->large_bump = run + offset + size;
+		table->large_end = run + SIZE_CLASS_RUN_SIZE;
+	}
+
+	return run + offset;
+}
+
+void *size_class_alloc(MemoryArena **const arena, const size_t allocation_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	HOT_INVARIANT(allocation_size <= SIZE_MAX - 2 * SIZE_CLASS_RUN_SIZE, ERR_ALLOCATION_TOO_LARGE, allocation_size,
+	              SIZE_MAX - 2 * SIZE_CLASS_RUN_SIZE);
+
+	SizeClassTable *table = (*arena)->state.sizeClassAllocatorState.table;
+	const size_t alignment = (*arena)->alignment;
+	const size_t size = (allocation_size + (alignment - 1)) & ~(alignment - 1);
+
+	if (unlikely(size > SIZE_CLASS_MAX_SIZE)) {
+		return size_class_alloc_large(*arena, table, size, alignment);
+	}
+
+	const size_t index = size_class_index(size);
+	SizeClass *size_class = &table->classes[index];
+
+	void *slot = size_class->free_list;
+	if (slot) {
+		memcpy(&size_class->free_list, slot, sizeof(void *));
+		memset(slot, 0x0, sizeof(void *));
+		size_class->live++;
+		return slot;
+	}
+
+	if (unlikely(size_class->bump == size_class->end)) {
+		char *run = size_class_carve(*arena, SIZE_CLASS_RUN_SIZE, index);
+		if (unlikely(!run)) {
+			return NULL;
+		}
+		const size_t slots = (SIZE_CLASS_RUN_SIZE - table->data_offset) / size_class->slot_size;
+
+		size_class->bump = run + table->data_offset;
+		size_class->end = size_class->bump + slots * size_class->slot_size;
+		size_class->runs++;
+		size_class->slots += slots;
+	}
+
+	slot = size_class->bump;
+	size_class->bump += size_class->slot_size;
+	size_class->live++;
+
+	return slot;
+}
+
+void *size_class_alloc_aligned(MemoryArena **const arena, const size_t allocation_size, const size_t alignment) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(alignment <= SIZE_CLASS_RUN_SIZE, ERR_ALLOC_ALIGNMENT_TOO_LARGE, SIZE_CLASS_RUN_SIZE, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	HOT_INVARIANT(allocation_size <= SIZE_MAX - 2 * SIZE_CLASS_RUN_SIZE, ERR_ALLOCATION_TOO_LARGE, allocation_size,
+	              SIZE_MAX - 2 * SIZE_CLASS_RUN_SIZE);
+
+	if (alignment <= (*arena)->alignment) {
+		return size_class_alloc(arena, allocation_size);
+	}
+
+	SizeClassTable *table = (*arena)->state.sizeClassAllocatorState.table;
+	const size_t size = (allocation_size + ((*arena)->alignment - 1)) & ~((*arena)->alignment - 1);
+
+	return size_class_alloc_large(*arena, table, size, alignment);
+}
+
+void size_class_dealloc(MemoryArena **const arena, void *const ptr) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+	HOT_INVARIANT(((uintptr_t)ptr & ((*arena)->alignment - 1)) == 0, ERR_INVALID_STATE, "ptr", "aligned",
+	              "misaligned");
+
+	const SizeClassRunHeader *run = (const SizeClassRunHeader *)((uintptr_t)ptr & ~(SIZE_CLASS_RUN_SIZE - 1));
+	if (run->size_class == SIZE_CLASS_LARGE) {
+		return;
+	}
+
+	HOT_INVARIANT(run->size_class < MEMORY_SIZE_CLASS_COUNT, ERR_LESS_THAN, "size_class", "MEMORY_SIZE_CLASS_COUNT",
+	              run->size_class, MEMORY_SIZE_CLASS_COUNT);
+
+	SizeClass *size_class = &(*arena)->state.sizeClassAllocatorState.table->classes[run->size_class];
+	HOT_INVARIANT(size_class->live != 0, ERR_OPERATION_INVALID_FOR_STATE, "free", "size class", "empty");
+
+	memset(ptr, 0x0, size_class->slot_size);
+	memcpy(ptr, &size_class->free_list, sizeof(void *));
+	size_class->free_list = ptr;
+	size_class->live--;
+}
+
+bool size_class_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	SizeClassTable *table = (*arena)->state.sizeClassAllocatorState.table;
+	const size_t alignment = (*arena)->alignment;
+	const SizeClassRunHeader *run = (const SizeClassRunHeader *)((uintptr_t)ptr & ~(SIZE_CLASS_RUN_SIZE - 1));
+
+	if (run->size_class != SIZE_CLASS_LARGE) {
+		return new_size <= table->classes[run->size_class].slot_size;
+	}
+
+	const size_t old_padded = (old_size + (alignment - 1)) & ~(alignment - 1);
+	if (new_size > SIZE_MAX - alignment || (char *)ptr + old_padded != table->large_bump) {
+		return false;
+	}
+
+	const size_t new_padded = (new_size + (alignment - 1)) & ~(alignment - 1);
+	if (new_padded > (size_t)(table->large_end - (char *)ptr)) {
+		return false;
+	}
+
+	if (new_padded < old_padded) {
+		memset((char *)ptr + new_padded, 0x0, old_padded - new_padded);
+	}
+
+	table->large_bump = (char *)ptr + new_padded;
+	return true;
+}
+
+bool size_class_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	/*
+	 * NOTE: Runs are carved from blocks that grow on demand, so an allocation can always be
+	 * satisfied unless the capacity limit leaves no room for a new block. Running out of system
+	 * memory is an invariant failure.
+	 */
+	if (arena->mapping_policy.limit == 0) {
+		return true;
+	}
+
+	const SizeClassTable *table = arena->state.sizeClassAllocatorState.table;
+	const size_t alignment = arena->alignment;
+	const size_t size = (allocation_size + (alignment - 1)) & ~(alignment - 1);
+
+	// Large allocations may need a span of several runs, slots one run.
+	size_t span = SIZE_CLASS_RUN_SIZE;
+	if (size > SIZE_CLASS_MAX_SIZE) {
+		if (table->large_bump && size <= (size_t)(table->large_end - table->large_bump)) {
+			return true;
+		}
+		const size_t offset = (table->data_offset + (alignment - 1)) & ~(alignment - 1);
+		span = (offset + size + (SIZE_CLASS_RUN_SIZE - 1)) & ~(SIZE_CLASS_RUN_SIZE - 1);
+	} else {
+		const SizeClass *size_class = &table->classes[size_class_index(size)];
+		if (size_class->free_list || size_class->bump != size_class->end) {
+			return true;
+		}
+	}
+
+	// Mirrors size_class_carve, which moves on through the blocks kept by a reset before growing.
+	const MemoryBlock *current = arena->state.sizeClassAllocatorState.cursor;
+	while (span > current->capacity - current->allocated) {
+		if (!current->next) {
+			return memory_block_next_capacity(&arena->mapping_policy, current->capacity, span,
+			                                  SIZE_CLASS_RUN_SIZE) != 0;
+		}
+		current = current->next;
+	}
+	return true;
+}
+
+size_t size_class_occupancy(const SizeClassTable *const table, MemorySizeClassOccupancy *const occupancy,
+                            const size_t count) {
+	INVARIANT(table, ERR_NULL_POINTER, "table");
+	INVARIANT(occupancy || count == 0, ERR_NULL_POINTER, "occupancy");
+
+	const size_t written = count < MEMORY_SIZE_CLASS_COUNT ? count : MEMORY_SIZE_CLASS_COUNT;
+	for (size_t index = 0; index < written; index++) {
+		const SizeClass *size_class = &table->classes[index];
+		occupancy[index] = (MemorySizeClassOccupancy){
+		    .slot_size = size_class->slot_size,
+		    .runs = size_class->runs,
+		    .slots = size_class->slots,
+		    .live = size_class->live,
+		};
+	}
+
+	return written;
+}
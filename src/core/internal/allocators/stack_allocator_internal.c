@@ -1,5 +1,6 @@
 #include "anvil/memory/internal/allocators/stack_allocator_internal.h"
 #include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
 #include "anvil/memory/internal/arena_internal.h"
 #include "anvil/memory/internal/error/error_templates.h"
 #include "anvil/memory/internal/utility_internal.h"
@@ -11,32 +12,24 @@ void stack_free(MemoryBlock *const memory_block) {
 	INVARIANT(memory_block->memory, ERR_NULL_POINTER, "memory_block->memory");
 
 	for (MemoryBlock *current = memory_block, *n; current && (n = current->next, 1); current = n) {
-		safe_aligned_free(current->memory);
-		free(current);
+		memory_block_destroy(current);
 	}
 }
 
-void stack_reset(MemoryBlock *const memory_block) {
+void stack_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
 
-	memset(memory_block->memory, 0x0, memory_block->allocated);
-	memory_block->allocated = 0;
-	if (memory_block->next) {
-		stack_free(memory_block->next);
-		memory_block->next = NULL;
-	}
-
-	return;
+	memory_block_chain_reset(memory_block, policy, mapping);
 }
 
-void *stack_alloc(MemoryBlock **const memory_block, const size_t allocation_size, const size_t alignment) {
-	INVARIANT(memory_block && (*memory_block), ERR_NULL_POINTER, "memory_block");
-	INVARIANT((*memory_block)->memory, ERR_NULL_POINTER, "memory_block->memory");
-	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
-	INVARIANT(alignment >= _Alignof(max_align_t), ERR_ALIGNMENT_TOO_SMALL, alignment, _Alignof(max_align_t));
-	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
-	INVARIANT((*memory_block)->next == NULL, ERR_OPERATION_INVALID_FOR_STATE, "allocation", "stack",
-	          "intermediate block");
+void *stack_alloc(MemoryBlock **const memory_block, const size_t allocation_size, const size_t alignment,
+                  MappingPolicy *const mapping) {
+	PARANOID_INVARIANT(memory_block && (*memory_block), ERR_NULL_POINTER, "memory_block");
+	PARANOID_INVARIANT((*memory_block)->memory, ERR_NULL_POINTER, "memory_block->memory");
+	PARANOID_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	PARANOID_INVARIANT((*memory_block)->next == NULL || (*memory_block)->next->allocated == 0,
+	                   ERR_OPERATION_INVALID_FOR_STATE, "allocation", "stack", "intermediate block");
 
 	MemoryBlock *current_block = (*memory_block);
 
@@ -51,15 +44,34 @@ void *stack_alloc(MemoryBlock **const memory_block, const size_t allocation_size
 		return (void *)aligned;
 	}
 
-	MemoryBlock *new_block = malloc(sizeof(MemoryBlock));
-	INVARIANT(new_block, ERR_OUT_OF_MEMORY, sizeof(MemoryBlock));
-
-	size_t new_capacity = current_block->capacity << 1;
+	/*
+	 * NOTE: Blocks past the top can only be empty blocks retained by a reset or cached by an
+	 * unwind. Reuse the first one the allocation fits at the alignment, releasing the ones before
+	 * it, otherwise grow as usual. Blocks created here are aligned to the allocation, so the
+	 * allocation starts at their first byte.
+	 */
+	MemoryBlock *new_block = current_block->next;
+	while (new_block) {
+		aligned = ((uintptr_t)new_block->memory + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+		offset = aligned - (uintptr_t)new_block->memory;
+		if (new_block->capacity >= allocation_size && new_block->capacity - allocation_size >= offset) {
+			break;
+		}
+		MemoryBlock *const skipped = new_block;
+		new_block = skipped->next;
+		skipped->next = NULL;
+		memory_block_chain_release(skipped, mapping);
+	}
 
-	new_block->memory = safe_aligned_alloc(new_capacity, alignment);
-	new_block->allocated = 0;
-	new_block->capacity = new_capacity;
-	new_block->next = NULL;
+	if (!new_block) {
+		const size_t new_capacity =
+		    memory_block_next_capacity(mapping, current_block->capacity, allocation_size, alignment);
+		if (unlikely(new_capacity == 0)) {
+			current_block->next = NULL;
+			return NULL;
+		}
+		new_block = memory_block_create(new_capacity, alignment, mapping);
+	}
 
 	current_block->next = new_block;
 	*memory_block = new_block;
@@ -72,15 +84,66 @@ void *stack_alloc(MemoryBlock **const memory_block, const size_t allocation_size
 	return (void *)aligned;
 }
 
-bool stack_alloc_verify(MemoryBlock *const memory_block, const size_t allocation_size, const size_t alignment) {
+void stack_cache(MemoryBlock *const top, size_t *const idle_unwinds, const ResetPolicy *const policy,
+                 MappingPolicy *const mapping) {
+	INVARIANT(top, ERR_NULL_POINTER, "top");
+	INVARIANT(idle_unwinds, ERR_NULL_POINTER, "idle_unwinds");
+	INVARIANT(policy, ERR_NULL_POINTER, "policy");
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
+
+	MemoryBlock *const cached = top->next;
+	if (!cached) {
+		*idle_unwinds = 0;
+		return;
+	}
+
+	*idle_unwinds = cached->allocated == 0 ? *idle_unwinds + 1 : 0;
+	if (*idle_unwinds >= STACK_CACHE_DECAY) {
+		memory_block_chain_release(cached, mapping);
+		top->next = NULL;
+		*idle_unwinds = 0;
+		return;
+	}
+
+	MemoryBlock *last_kept = top;
+	for (size_t kept = 0; kept < STACK_CACHE_BLOCKS && last_kept->next; kept++) {
+		last_kept = last_kept->next;
+		memory_block_rewind(last_kept, 0, policy);
+	}
+
+	if (last_kept->next) {
+		memory_block_chain_release(last_kept->next, mapping);
+		last_kept->next = NULL;
+	}
+}
+
+bool stack_alloc_verify(MemoryBlock *const memory_block, const size_t allocation_size, const size_t alignment,
+                        const MappingPolicy *const mapping) {
 	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
 	INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
 	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+	INVARIANT(mapping, ERR_NULL_POINTER, "mapping");
 
 	/*
-	 * NOTE:(UniquesKernel) Because the memory allocation is dynamic it should always return true
-	 * when asked if the arena can handle an allocation. If the system runs out of memory because of
-	 * a malloc failure, then an invariant issue should cause a system failure.
+	 * NOTE: Blocks are created on demand, so an allocation only fails when it fits neither the
+	 * top block nor a block past it and the capacity limit leaves no room for a block that holds
+	 * it. Running out of system memory is an invariant failure.
 	 */
-	return true;
+	const uintptr_t current = (uintptr_t)memory_block->memory + memory_block->allocated;
+	const size_t offset = (size_t)(((current + (alignment - 1)) & ~(uintptr_t)(alignment - 1)) - current);
+	const size_t available = memory_block->capacity - memory_block->allocated;
+
+	if (offset <= available && allocation_size <= available - offset) {
+		return true;
+	}
+
+	for (const MemoryBlock *next = memory_block->next; next; next = next->next) {
+		const uintptr_t start = (uintptr_t)next->memory;
+		const size_t padding = (size_t)(((start + (alignment - 1)) & ~(uintptr_t)(alignment - 1)) - start);
+		if (next->capacity >= allocation_size && next->capacity - allocation_size >= padding) {
+			return true;
+		}
+	}
+
+	return memory_block_next_capacity(mapping, memory_block->capacity, allocation_size, alignment) != 0;
 }
@@ -0,0 +1,129 @@
+#include "anvil/memory/internal/allocators/virtual_allocator_internal.h"
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/allocation/memory_block_internal.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*****************************************************************************************************
+ *					Virtual Allocator
+ * ***************************************************************************************************/
+
+void virtual_free(MemoryBlock *const memory_block) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	// Reserved blocks are partially inaccessible and must never reach the block recycler.
+	memory_block_unmap(memory_block);
+}
+
+void virtual_reset(MemoryBlock *const memory_block, ResetPolicy *const policy, MappingPolicy *const mapping) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	memory_block_chain_reset(memory_block, policy, mapping);
+}
+
+size_t virtual_commit(MemoryBlock *const memory_block, const size_t committed, const size_t size) {
+	INVARIANT(memory_block, ERR_NULL_POINTER, "memory_block");
+
+	const size_t capacity = memory_block->capacity;
+	const size_t result = safe_aligned_commit(memory_block->memory, committed, size < capacity ? size : capacity);
+
+	return result < capacity ? result : capacity;
+}
+
+/*
+ * Moves the allocation offset of the reservation to `end`, committing at least
+ * `VIRTUAL_COMMIT_STEP` more bytes when it reaches past the committed pages.
+ */
+static inline void virtual_advance(MemoryBlock *const memory_block, VirtualAllocatorState *const state,
+                                   const size_t end) {
+	if (unlikely(end > state->committed)) {
+		const size_t step =
+		    end - state->committed < VIRTUAL_COMMIT_STEP ? state->committed + VIRTUAL_COMMIT_STEP : end;
+		state->committed = virtual_commit(memory_block, state->committed, step);
+	}
+
+	memory_block->allocated = end;
+}
+
+void *virtual_alloc(MemoryArena **const arena, const size_t allocation_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	MemoryBlock *memory_block = (*arena)->memory_block;
+	const size_t alignment = (*arena)->alignment;
+
+	/*
+	 * NOTE: The reserved capacity is a multiple of the alignment and every allocation is padded
+	 * to it, so the allocation offset stays aligned and the padded size fits whenever the
+	 * requested size does.
+	 */
+	if (unlikely(allocation_size > memory_block->capacity - memory_block->allocated)) {
+		return NULL;
+	}
+	const size_t size = (allocation_size + (alignment - 1)) & ~(alignment - 1);
+
+	void *result = (char *)memory_block->memory + memory_block->allocated;
+	virtual_advance(memory_block, &(*arena)->state.virtualAllocatorState, memory_block->allocated + size);
+
+	return result;
+}
+
+void *virtual_alloc_aligned(MemoryArena **const arena, const size_t allocation_size, const size_t alignment) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	PARANOID_INVARIANT((*arena)->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	HOT_INVARIANT(is_power_of_two(alignment), ERR_ALLOC_ALIGNMENT_NOT_POWER_OF_TWO, alignment);
+	HOT_INVARIANT(alignment >= (*arena)->alignment, ERR_ALIGNMENT_TOO_SMALL, (*arena)->alignment, alignment);
+	HOT_INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	MemoryBlock *memory_block = (*arena)->memory_block;
+	const size_t arena_alignment = (*arena)->alignment;
+
+	const uintptr_t current = (uintptr_t)memory_block->memory + memory_block->allocated;
+	const uintptr_t aligned = (current + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+	const size_t offset = (size_t)(aligned - current);
+	const size_t available = memory_block->capacity - memory_block->allocated;
+
+	if (unlikely(offset > available || allocation_size > available - offset)) {
+		return NULL;
+	}
+	const size_t size = (allocation_size + (arena_alignment - 1)) & ~(arena_alignment - 1);
+
+	virtual_advance(memory_block, &(*arena)->state.virtualAllocatorState,
+	                memory_block->allocated + offset + size);
+
+	return (void *)aligned;
+}
+
+bool virtual_resize(MemoryArena **const arena, void *const ptr, const size_t old_size, const size_t new_size) {
+	PARANOID_INVARIANT(arena && (*arena), ERR_NULL_POINTER, "arena");
+	HOT_INVARIANT(ptr, ERR_NULL_POINTER, "ptr");
+
+	MemoryBlock *memory_block = (*arena)->memory_block;
+	const size_t alignment = (*arena)->alignment;
+
+	if (old_size > SIZE_MAX - alignment || new_size > SIZE_MAX - alignment) {
+		return false;
+	}
+
+	const size_t old_padded = (old_size + (alignment - 1)) & ~(alignment - 1);
+	const size_t new_padded = (new_size + (alignment - 1)) & ~(alignment - 1);
+	if (!memory_block_resize_last(memory_block, ptr, old_padded, new_padded)) {
+		return false;
+	}
+
+	virtual_advance(memory_block, &(*arena)->state.virtualAllocatorState, memory_block->allocated);
+	return true;
+}
+
+bool virtual_alloc_verify(MemoryArena *const arena, const size_t allocation_size) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+	INVARIANT(arena->memory_block, ERR_NULL_POINTER, "arena->memory_block");
+	INVARIANT(allocation_size != 0, ERR_ALLOC_SIZE_ZERO);
+
+	return allocation_size <= arena->memory_block->capacity - arena->memory_block->allocated;
+}
@@ -0,0 +1,60 @@
+#include "anvil/memory/internal/arena_registry_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <pthread.h>
+#include <string.h>
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static MemoryArena *registry_head = NULL;
+
+void arena_registry_add(MemoryArena *const arena) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+
+	pthread_mutex_lock(&registry_lock);
+	arena->registry_prev = NULL;
+	arena->registry_next = registry_head;
+	if (registry_head) {
+		registry_head->registry_prev = arena;
+	}
+	registry_head = arena;
+	pthread_mutex_unlock(&registry_lock);
+}
+
+void arena_registry_remove(MemoryArena *const arena) {
+	INVARIANT(arena, ERR_NULL_POINTER, "arena");
+
+	pthread_mutex_lock(&registry_lock);
+	if (arena->registry_prev) {
+		arena->registry_prev->registry_next = arena->registry_next;
+	} else {
+		registry_head = arena->registry_next;
+	}
+	if (arena->registry_next) {
+		arena->registry_next->registry_prev = arena->registry_prev;
+	}
+	arena->registry_prev = NULL;
+	arena->registry_next = NULL;
+	pthread_mutex_unlock(&registry_lock);
+}
+
+void arena_registry_collect(MemoryGlobalStats *const stats) {
+	INVARIANT(stats, ERR_NULL_POINTER, "stats");
+
+	memset(stats, 0x0, sizeof(*stats));
+
+	pthread_mutex_lock(&registry_lock);
+	for (MemoryArena *arena = registry_head; arena; arena = arena->registry_next) {
+		const MappingPolicy *const mapping = &arena->mapping_policy;
+
+		stats->arenas++;
+		stats->allocations += __atomic_load_n(&arena->stats.allocations, __ATOMIC_RELAXED);
+		stats->bytes_requested += __atomic_load_n(&arena->stats.requested, __ATOMIC_RELAXED);
+		stats->blocks += __atomic_load_n(&mapping->blocks, __ATOMIC_RELAXED);
+		stats->capacity += __atomic_load_n(&mapping->capacity, __ATOMIC_RELAXED);
+		stats->block_maps += __atomic_load_n(&mapping->maps, __ATOMIC_RELAXED);
+		stats->block_reuses += __atomic_load_n(&mapping->reuses, __ATOMIC_RELAXED);
+		stats->block_releases += __atomic_load_n(&mapping->releases, __ATOMIC_RELAXED);
+		stats->block_unmaps += __atomic_load_n(&mapping->unmaps, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&registry_lock);
+}
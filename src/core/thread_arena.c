@@ -0,0 +1,76 @@
+#include "anvil/memory/arena.h"
+#include "anvil/memory/internal/allocation/block_recycler_internal.h"
+#include "anvil/memory/internal/allocation/memory_allocation_internal.h"
+#include "anvil/memory/internal/arena_internal.h"
+#include "anvil/memory/internal/error/error_templates.h"
+#include "anvil/memory/internal/utility_internal.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#define THREAD_ARENA_INITIAL_SIZE ((size_t)1 << 16)
+
+static pthread_key_t thread_arena_key;
+static pthread_once_t thread_arena_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local MemoryArena *thread_arena = NULL;
+
+static void thread_arena_destroy(void *arena) {
+	MemoryArena *exiting_arena = arena;
+	memory_arena_destroy(&exiting_arena);
+	thread_arena = NULL;
+}
+
+static void thread_arena_key_create(void) {
+	int result = pthread_key_create(&thread_arena_key, thread_arena_destroy);
+	INVARIANT(result == 0, ERR_INVALID_STATE, "thread arena key", "created", "failed");
+}
+
+/*
+ * Creates the calling thread's arena with the given options and registers its thread-exit hook.
+ */
+static MemoryArena *thread_arena_create(const MemoryArenaOptions *const options) {
+	pthread_once(&thread_arena_key_once, thread_arena_key_create);
+
+	thread_arena =
+	    memory_arena_create_with_options(LINEAR, _Alignof(max_align_t), THREAD_ARENA_INITIAL_SIZE, options);
+	int result = pthread_setspecific(thread_arena_key, thread_arena);
+	INVARIANT(result == 0, ERR_INVALID_STATE, "thread arena", "registered", "unregistered");
+
+	return thread_arena;
+}
+
+MemoryArena *memory_thread_arena(void) {
+	if (likely(thread_arena)) {
+		return thread_arena;
+	}
+
+	return thread_arena_create(NULL);
+}
+
+MemoryArena *memory_thread_arena_on_node(const size_t node) {
+	if (thread_arena) {
+		INVARIANT(thread_arena->mapping_policy.numa_policy == MEMORY_NUMA_BIND &&
+		              thread_arena->mapping_policy.numa_node == node,
+		          ERR_INVALID_STATE, "thread arena", "bound to the node", "placed elsewhere");
+		return thread_arena;
+	}
+
+	const MemoryArenaOptions options = {.numa_policy = MEMORY_NUMA_BIND, .numa_node = node};
+	return thread_arena_create(&options);
+}
+
+void memory_thread_arena_release(void) {
+	if (!thread_arena) {
+		return;
+	}
+
+	pthread_setspecific(thread_arena_key, NULL);
+	memory_arena_destroy(&thread_arena);
+}
+
+size_t memory_numa_node(void) {
+	return safe_numa_current_node();
+}
+
+void memory_recycler_drain(void) {
+	block_recycler_drain();
+}
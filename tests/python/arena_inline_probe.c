@@ -0,0 +1,54 @@
+/**
+ * @file arena_inline_probe.c
+ * @brief Exposes the header-only inline allocation fast path to the Python tests.
+ *
+ * `MEMORY_ARENA_ALLOC_INLINE` only exists in `arena_inline.h` and is specialized at compile
+ * time, so the tests can not call it through the library. This probe instantiates it for every
+ * allocator type with a fast path and a few alignments, and is built next to the test library
+ * it links against when `BUILD_TESTING` is on.
+ */
+
+#include "anvil/memory/arena_inline.h"
+#include <stddef.h>
+
+#define PROBE_ALIGNMENTS(type)                                                                                         \
+	switch (alignment) {                                                                                           \
+		case 8:                                                                                                \
+			return MEMORY_ARENA_ALLOC_INLINE(arena, type, 8, size);                                        \
+		case 16:                                                                                               \
+			return MEMORY_ARENA_ALLOC_INLINE(arena, type, 16, size);                                       \
+		case 64:                                                                                               \
+			return MEMORY_ARENA_ALLOC_INLINE(arena, type, 64, size);                                       \
+		default:                                                                                               \
+			return NULL;                                                                                   \
+	}
+
+/**
+ * @brief Allocates `size` bytes through the inline fast path of `type` at `alignment`.
+ *
+ * @param[in,out] `arena` Arena created with `type` and `alignment`.
+ * @param[in] `type` SCRATCH, LINEAR, STACK or VIRTUAL.
+ * @param[in] `alignment` Alignment of the arena, 8, 16 or 64.
+ * @param[in] `size` Amount of memory to allocate.
+ *
+ * @return What the fast path returned, or `NULL` for a type or alignment without one.
+ */
+void *arena_inline_probe_alloc(MemoryArena **const arena, const AllocatorType type, const size_t alignment,
+                               const size_t size) {
+	switch (type) {
+		case SCRATCH:
+			PROBE_ALIGNMENTS(SCRATCH)
+		case LINEAR:
+			PROBE_ALIGNMENTS(LINEAR)
+		case STACK:
+			PROBE_ALIGNMENTS(STACK)
+		case VIRTUAL:
+			PROBE_ALIGNMENTS(VIRTUAL)
+		case POOL:
+		case CONCURRENT:
+		case SIZE_CLASS:
+		case COUNT:
+		default:
+			return NULL;
+	}
+}
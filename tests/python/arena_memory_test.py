@@ -1,10 +1,13 @@
 import ctypes
+import threading
 import hypothesis
-from hypothesis.stateful import RuleBasedStateMachine, precondition, rule
+from hypothesis import assume, given
+from hypothesis.stateful import RuleBasedStateMachine, invariant, precondition, rule
 from enum import IntEnum
 
-from hypothesis.strategies import integers, sampled_from
+from hypothesis.strategies import integers, lists, sampled_from
 lib = ctypes.CDLL("./build/libmemory_test.so")
+probe = ctypes.CDLL("./build/libmemory_inline_probe.so")
 
 """
 Memory Arena, AllocatorType, ArenaErrorCode and 
@@ -13,12 +16,133 @@ function bindings for Memory arena and linear allocator
 class MemoryArena(ctypes.Structure):
     pass
 
+class MemoryArenaOptions(ctypes.Structure):
+    _fields_ = [
+        ("retain_blocks", ctypes.c_size_t),
+        ("retain_bytes", ctypes.c_size_t),
+        ("retain_decay", ctypes.c_size_t),
+        ("pool_slot_size", ctypes.c_size_t),
+        ("reset_release_threshold", ctypes.c_size_t),
+        ("virtual_reserve", ctypes.c_size_t),
+        ("growth_factor", ctypes.c_size_t),
+        ("growth_chunk", ctypes.c_size_t),
+        ("max_block_size", ctypes.c_size_t),
+        ("capacity_limit", ctypes.c_size_t),
+        ("large_threshold", ctypes.c_size_t),
+        ("numa_node", ctypes.c_size_t),
+        ("reset_zeroing", ctypes.c_int),
+        ("numa_policy", ctypes.c_int),
+        ("best_fit", ctypes.c_bool),
+        ("huge_pages", ctypes.c_bool),
+        ("sensitive", ctypes.c_bool),
+        ("prefault", ctypes.c_bool),
+        ("spare_block", ctypes.c_bool),
+    ]
+
+SIZE_MAX = ctypes.c_size_t(-1).value
+
 class AllocatorType(IntEnum):
     SCRATCH = 0
     LINEAR = 1
     STACK = 2
     POOL = 3
-    # COUNT = 4
+    CONCURRENT = 4
+    SIZE_CLASS = 5
+    VIRTUAL = 6
+    # COUNT = 7
+
+class MemoryResetZeroing(IntEnum):
+    EAGER = 0
+    NONE = 1
+    RELEASE = 2
+
+class MemoryNumaPolicy(IntEnum):
+    DEFAULT = 0
+    BIND = 1
+    INTERLEAVE = 2
+
+# Memory policy modes and flags of get_mempolicy(2), see <linux/mempolicy.h>
+MPOL_DEFAULT = 0
+MPOL_BIND = 2
+MPOL_INTERLEAVE = 3
+MPOL_F_ADDR = 1 << 1
+SYS_get_mempolicy = 239
+
+libc = ctypes.CDLL(None, use_errno=True)
+libc.mincore.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(ctypes.c_ubyte)]
+PAGE_SIZE = 4096
+
+def page_resident(address):
+    vec = ctypes.c_ubyte()
+    assert libc.mincore(address & ~(PAGE_SIZE - 1), PAGE_SIZE, ctypes.byref(vec)) == 0
+    return vec.value & 1 == 1
+
+class MemoryPageBacking(IntEnum):
+    DEFAULT = 0
+    TRANSPARENT = 1
+    HUGETLB = 2
+
+FREEABLE_TYPES = (AllocatorType.POOL, AllocatorType.SIZE_CLASS)
+
+SIZE_CLASS_MAX_SIZE = 512
+SIZE_CLASS_MAX_EXPONENT = 15
+MAX_ALIGNMENT_EXPONENT = 16
+
+class MemorySizeClassOccupancy(ctypes.Structure):
+    _fields_ = [
+        ("slot_size", ctypes.c_size_t),
+        ("runs", ctypes.c_size_t),
+        ("slots", ctypes.c_size_t),
+        ("live", ctypes.c_size_t),
+    ]
+
+MEMORY_SIZE_CLASS_COUNT = 16
+
+class MemoryArenaStats(ctypes.Structure):
+    _fields_ = [
+        ("allocations", ctypes.c_size_t),
+        ("bytes_requested", ctypes.c_size_t),
+        ("bytes_used", ctypes.c_size_t),
+        ("padding", ctypes.c_size_t),
+        ("high_water", ctypes.c_size_t),
+        ("blocks", ctypes.c_size_t),
+        ("capacity", ctypes.c_size_t),
+        ("block_maps", ctypes.c_size_t),
+        ("block_reuses", ctypes.c_size_t),
+        ("block_releases", ctypes.c_size_t),
+        ("block_unmaps", ctypes.c_size_t),
+        ("page_backing", ctypes.c_int),
+    ]
+
+class MemoryStackMark(ctypes.Structure):
+    _fields_ = [
+        ("block", ctypes.c_void_p),
+        ("allocated", ctypes.c_size_t),
+        ("requested", ctypes.c_size_t),
+        ("snapshots", ctypes.c_size_t),
+    ]
+
+class MemoryArenaCheckpoint(ctypes.Structure):
+    _fields_ = [
+        ("position", ctypes.c_size_t),
+        ("large", ctypes.c_void_p),
+        ("snapshots", ctypes.c_size_t),
+    ]
+
+class MemoryGlobalStats(ctypes.Structure):
+    _fields_ = [
+        ("arenas", ctypes.c_size_t),
+        ("allocations", ctypes.c_size_t),
+        ("bytes_requested", ctypes.c_size_t),
+        ("blocks", ctypes.c_size_t),
+        ("capacity", ctypes.c_size_t),
+        ("block_maps", ctypes.c_size_t),
+        ("block_reuses", ctypes.c_size_t),
+        ("block_releases", ctypes.c_size_t),
+        ("block_unmaps", ctypes.c_size_t),
+        ("mmap_calls", ctypes.c_size_t),
+        ("munmap_calls", ctypes.c_size_t),
+    ]
 
 lib.memory_arena_create.argtypes = [
     ctypes.c_int,
@@ -27,6 +151,14 @@ lib.memory_arena_create.argtypes = [
 ]
 lib.memory_arena_create.restype = ctypes.POINTER(MemoryArena)
 
+lib.memory_arena_create_with_options.argtypes = [
+    ctypes.c_int,
+    ctypes.c_size_t,
+    ctypes.c_size_t,
+    ctypes.POINTER(MemoryArenaOptions)
+]
+lib.memory_arena_create_with_options.restype = ctypes.POINTER(MemoryArena)
+
 lib.memory_arena_destroy.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena))]
 
 lib.memory_arena_reset.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena))]
@@ -37,9 +169,93 @@ lib.memory_arena_alloc.argtypes = [
 ]
 lib.memory_arena_alloc.restype = ctypes.c_void_p
 
+lib.memory_arena_alloc_aligned.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.c_size_t,
+    ctypes.c_size_t
+]
+lib.memory_arena_alloc_aligned.restype = ctypes.c_void_p
+
+lib.memory_arena_alloc_batch.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.POINTER(ctypes.c_size_t),
+    ctypes.c_size_t,
+    ctypes.POINTER(ctypes.c_void_p)
+]
+lib.memory_arena_alloc_batch.restype = ctypes.c_bool
+
+lib.memory_arena_alloc_batch_uniform.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.c_size_t,
+    ctypes.c_size_t,
+    ctypes.POINTER(ctypes.c_void_p)
+]
+lib.memory_arena_alloc_batch_uniform.restype = ctypes.c_bool
+
+lib.memory_arena_realloc.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.c_void_p,
+    ctypes.c_size_t,
+    ctypes.c_size_t
+]
+lib.memory_arena_realloc.restype = ctypes.c_void_p
+
+lib.memory_arena_free.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.c_void_p
+]
+
+lib.memory_arena_size_class_occupancy.argtypes = [
+    ctypes.POINTER(MemoryArena),
+    ctypes.POINTER(MemorySizeClassOccupancy),
+    ctypes.c_size_t
+]
+lib.memory_arena_size_class_occupancy.restype = ctypes.c_size_t
+
+lib.memory_arena_get_stats.argtypes = [ctypes.POINTER(MemoryArena), ctypes.POINTER(MemoryArenaStats)]
+
+lib.memory_arena_get_global_stats.argtypes = [ctypes.POINTER(MemoryGlobalStats)]
+
 lib.memory_arena_alloc_verify.argtypes = [ctypes.POINTER(MemoryArena), ctypes.c_size_t]
 lib.memory_arena_alloc_verify.restype = ctypes.c_bool
 
+lib.memory_thread_arena.argtypes = []
+lib.memory_thread_arena.restype = ctypes.POINTER(MemoryArena)
+
+lib.memory_thread_arena_release.argtypes = []
+
+lib.memory_recycler_drain.argtypes = []
+lib.memory_recycler_drain.restype = None
+
+probe.arena_inline_probe_alloc.argtypes = [
+    ctypes.POINTER(ctypes.POINTER(MemoryArena)),
+    ctypes.c_int,
+    ctypes.c_size_t,
+    ctypes.c_size_t
+]
+probe.arena_inline_probe_alloc.restype = ctypes.c_void_p
+
+lib.memory_thread_arena_on_node.argtypes = [ctypes.c_size_t]
+lib.memory_thread_arena_on_node.restype = ctypes.POINTER(MemoryArena)
+
+lib.memory_numa_node.argtypes = []
+lib.memory_numa_node.restype = ctypes.c_size_t
+
+lib.memory_stack_arena_record.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena))]
+lib.memory_stack_arena_record.restype = None
+lib.memory_stack_arena_unwind.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena))]
+lib.memory_stack_arena_unwind.restype = None
+
+lib.memory_stack_arena_mark.argtypes = [ctypes.POINTER(MemoryArena)]
+lib.memory_stack_arena_mark.restype = MemoryStackMark
+lib.memory_stack_arena_restore.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena)), MemoryStackMark]
+lib.memory_stack_arena_restore.restype = None
+
+lib.memory_arena_checkpoint.argtypes = [ctypes.POINTER(MemoryArena)]
+lib.memory_arena_checkpoint.restype = MemoryArenaCheckpoint
+lib.memory_arena_rollback.argtypes = [ctypes.POINTER(ctypes.POINTER(MemoryArena)), MemoryArenaCheckpoint]
+lib.memory_arena_rollback.restype = None
+
 """
 Checking for system alignment requirement for most common architectures 
 that anvil supports this will come down to long double or double.
@@ -60,27 +276,123 @@ class MemoryArenaModel(RuleBasedStateMachine):
     def __init__(self):
         super().__init__()
         self.arena = ctypes.POINTER(MemoryArena)()
+        self.allocator_type = None
+        self.alignment = 0
+        self.huge_pages = False
+        self.zeroing = MemoryResetZeroing.EAGER
+        self.limit = 0
+        self.live = []
 
     """
     Only create an arena if non exists. Only generate alignments 
-    that are powers of two and larger than or equal to the minimum
-    system architecture alignment. 
+    that are powers of two, including ones below the minimum system
+    architecture alignment for tightly packed arenas.
 
-    exponent capped at 1 to ensure alignment stays within reasonable 
-    limit of 4KB.
+    exponent capped at 16 to ensure alignment stays within reasonable 
+    limit of 64KB. Size class arenas need an alignment below their 64KB runs.
     """
     @rule(
-        exponent=integers(min_value=0,max_value=12),
+        exponent=integers(min_value=0,max_value=MAX_ALIGNMENT_EXPONENT),
         capacity=integers(min_value=1, max_value=(1 << 20)),
         allocatorType=sampled_from(AllocatorType)
     )
     @precondition(lambda self: not self.arena)
     def create_arena(self, capacity, exponent, allocatorType):
-        alignment = SIZE << exponent
+        if allocatorType == AllocatorType.SIZE_CLASS:
+            exponent = min(exponent, SIZE_CLASS_MAX_EXPONENT)
+        alignment = 1 << exponent
         self.arena = lib.memory_arena_create(allocatorType, alignment, capacity)
+        self.allocator_type = allocatorType
+        self.alignment = alignment
+        self.huge_pages = False
+        self.zeroing = MemoryResetZeroing.EAGER
+        self.limit = 0
+
+        assert self.arena
+
+    """
+    Arenas created with options must follow the same model as plain arenas,
+    whatever blocks they decide to keep across a reset.
+    """
+    @rule(
+        exponent=integers(min_value=0,max_value=MAX_ALIGNMENT_EXPONENT),
+        capacity=integers(min_value=1, max_value=(1 << 20)),
+        allocatorType=sampled_from(AllocatorType),
+        retainBlocks=sampled_from([0, 1, 2, SIZE_MAX]),
+        retainBytes=integers(min_value=0, max_value=(1 << 22)),
+        retainDecay=integers(min_value=0, max_value=4),
+        poolSlotSize=integers(min_value=0, max_value=(1 << 11)),
+        resetReleaseThreshold=sampled_from([0, 1, 4096, (1 << 16)]),
+        virtualReserve=sampled_from([0, (1 << 20), (1 << 24)]),
+        growthFactor=sampled_from([0, 1, 3, SIZE_MAX]),
+        growthChunk=sampled_from([0, 4096, (1 << 16)]),
+        maxBlockSize=sampled_from([0, 1, (1 << 16)]),
+        limitHeadroom=sampled_from([None, 0, (1 << 16), (1 << 22)]),
+        largeThreshold=sampled_from([0, 1, (1 << 12)]),
+        resetZeroing=sampled_from(MemoryResetZeroing),
+        numaPolicy=sampled_from(MemoryNumaPolicy),
+        bestFit=sampled_from([False, True]),
+        hugePages=sampled_from([False, True]),
+        sensitive=sampled_from([False, True]),
+        prefault=sampled_from([False, True]),
+        spareBlock=sampled_from([False, True])
+    )
+    @precondition(lambda self: not self.arena)
+    def create_arena_with_options(self, capacity, exponent, allocatorType, retainBlocks, retainBytes, retainDecay,
+                                  poolSlotSize, resetReleaseThreshold, virtualReserve, growthFactor, growthChunk,
+                                  maxBlockSize, limitHeadroom, largeThreshold, resetZeroing, numaPolicy, bestFit,
+                                  hugePages, sensitive, prefault, spareBlock):
+        if allocatorType == AllocatorType.SIZE_CLASS:
+            exponent = min(exponent, SIZE_CLASS_MAX_EXPONENT)
+        alignment = 1 << exponent
+
+        # The capacity limit leaves the given headroom above the largest first block the arena may map
+        limit = 0
+        if limitHeadroom is not None:
+            first = max(capacity, virtualReserve) if allocatorType == AllocatorType.VIRTUAL else capacity
+            granule = (1 << 16) if allocatorType == AllocatorType.SIZE_CLASS else alignment
+            first = -(-first // granule) * granule
+            if hugePages and allocatorType != AllocatorType.VIRTUAL:
+                first = -(-(first + (1 << 17)) // (1 << 21)) * (1 << 21)
+            limit = first + limitHeadroom
+
+        options = MemoryArenaOptions(retainBlocks, retainBytes, retainDecay, poolSlotSize, resetReleaseThreshold,
+                                     virtualReserve, growthFactor, growthChunk, maxBlockSize, limit, largeThreshold,
+                                     0, resetZeroing, numaPolicy, bestFit, hugePages, sensitive, prefault,
+                                     spareBlock)
+        self.arena = lib.memory_arena_create_with_options(allocatorType, alignment, capacity, ctypes.byref(options))
+        self.allocator_type = allocatorType
+        self.alignment = alignment
+        self.huge_pages = hugePages
+        self.zeroing = MemoryResetZeroing.EAGER if sensitive else resetZeroing
+        self.limit = limit
 
         assert self.arena
 
+    """
+    The blocks of an arena never add up to more than its capacity limit,
+    whatever rules ran before.
+    """
+    @invariant()
+    def capacity_within_limit(self):
+        if self.arena and self.limit:
+            stats = MemoryArenaStats()
+            lib.memory_arena_get_stats(self.arena, ctypes.byref(stats))
+            assert stats.capacity <= self.limit
+
+    """
+    Arenas only report huge page backing when they asked for it.
+    """
+    @rule()
+    @precondition(lambda self: self.arena)
+    def page_backing(self):
+        stats = MemoryArenaStats()
+        lib.memory_arena_get_stats(self.arena, ctypes.byref(stats))
+        backing = stats.page_backing
+        assert backing in list(MemoryPageBacking)
+        if not self.huge_pages:
+            assert backing == MemoryPageBacking.DEFAULT
+
     """
     Only destroy arena if one exists.
     """
@@ -89,6 +401,7 @@ class MemoryArenaModel(RuleBasedStateMachine):
     def arena_destroy(self):
         lib.memory_arena_destroy(self.arena)
         self.arena = ctypes.POINTER(MemoryArena)()
+        self.live = []
 
         assert not self.arena
 
@@ -99,6 +412,26 @@ class MemoryArenaModel(RuleBasedStateMachine):
     @precondition(lambda self: self.arena)
     def arena_reset(self):
         lib.memory_arena_reset(ctypes.pointer(self.arena))
+        self.live = []
+
+    """
+    Memory handed out after a reset reads as zero unless the arena was
+    created without reset zeroing, whether it was zeroed or released.
+    """
+    @rule(allocSize=integers(1, (1 << 16)), data=integers(1, 255))
+    @precondition(lambda self: self.arena and self.zeroing != MemoryResetZeroing.NONE)
+    def reset_zeroes(self, allocSize, data):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        if ptr:
+            ctypes.memset(ptr, data, allocSize)
+        lib.memory_arena_reset(ctypes.pointer(self.arena))
+        self.live = []
+
+        ptr = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        if ptr:
+            assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+            if self.allocator_type in FREEABLE_TYPES:
+                self.live.append((ptr, allocSize))
 
     """
     Only allocate memory from arena if it exists and we haven't 
@@ -108,8 +441,185 @@ class MemoryArenaModel(RuleBasedStateMachine):
     @rule(allocSize=integers(1,(1 << 10)))
     @precondition(lambda self: self.arena)
     def alloc(self, allocSize):
-        lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        ptr = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
         # No assertions - this rule just helps generate different arena states
+        if ptr and self.allocator_type in FREEABLE_TYPES:
+            self.live.append((ptr, allocSize))
+
+    """
+    Aligned allocations honour the stricter of their own and the arena
+    alignment. Pool slots can not be aligned beyond the arena alignment,
+    and size class arenas serve such allocations as large allocations.
+    """
+    @rule(allocSize=integers(1, (1 << 12)), exponent=integers(0, MAX_ALIGNMENT_EXPONENT), data=integers(0, 255))
+    @precondition(lambda self: self.arena)
+    def alloc_aligned(self, allocSize, exponent, data):
+        alignment = 1 << exponent
+        ptr = lib.memory_arena_alloc_aligned(ctypes.pointer(self.arena), allocSize, alignment)
+
+        if self.allocator_type == AllocatorType.POOL and alignment > self.alignment:
+            assert not ptr
+        if ptr:
+            assert ptr % max(alignment, self.alignment) == 0
+            ctypes.memset(ptr, data, allocSize)
+            if self.allocator_type in FREEABLE_TYPES and alignment <= self.alignment:
+                self.live.append((ptr, allocSize))
+
+    """
+    A batch either fills every pointer with aligned, non-overlapping memory
+    or none of them. Bump allocated arenas lay the batch out back to back.
+    """
+    @rule(sizes=lists(integers(1, (1 << 10)), min_size=1, max_size=64), uniform=sampled_from([False, True]))
+    @precondition(lambda self: self.arena)
+    def alloc_batch(self, sizes, uniform):
+        count = len(sizes)
+        if uniform:
+            sizes = [sizes[0]] * count
+        out = (ctypes.c_void_p * count)()
+        if uniform:
+            ok = lib.memory_arena_alloc_batch_uniform(ctypes.pointer(self.arena), sizes[0], count, out)
+        else:
+            ok = lib.memory_arena_alloc_batch(ctypes.pointer(self.arena), (ctypes.c_size_t * count)(*sizes),
+                                              count, out)
+
+        if not ok:
+            assert not any(out)
+            return
+
+        assert all(ptr % self.alignment == 0 for ptr in out)
+        spans = sorted(zip(out, sizes))
+        for (ptr, size), (next_ptr, _) in zip(spans, spans[1:]):
+            assert ptr + size <= next_ptr
+        if self.allocator_type in FREEABLE_TYPES:
+            self.live.extend(zip(out, sizes))
+        else:
+            padded = [-(-size // self.alignment) * self.alignment for size in sizes]
+            assert list(out) == [out[0] + sum(padded[:i]) for i in range(count)]
+
+    """
+    Resized memory keeps its contents. Shrinking never moves an allocation,
+    and the most recent allocation of a scratch or virtual arena is always
+    grown in place or not at all. Size class slots resized in place keep
+    their class, and moved ones are freed by the resize.
+    """
+    @rule(oldSize=integers(1, (1 << 10)), newSize=integers(1, (1 << 12)), data=integers(1, 255))
+    @precondition(lambda self: self.arena)
+    def realloc(self, oldSize, newSize, data):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(self.arena), oldSize)
+        if not ptr:
+            return
+        ctypes.memset(ptr, data, oldSize)
+        resized = lib.memory_arena_realloc(ctypes.pointer(self.arena), ptr, oldSize, newSize)
+
+        if newSize <= oldSize:
+            assert resized == ptr
+        if self.allocator_type in (AllocatorType.SCRATCH, AllocatorType.VIRTUAL):
+            assert resized in (None, ptr)
+        kept = min(oldSize, newSize)
+        if resized:
+            assert ctypes.string_at(resized, kept) == bytes([data]) * kept
+
+        if self.allocator_type in FREEABLE_TYPES:
+            if resized and resized != ptr:
+                self.live.append((resized, newSize))
+            elif self.allocator_type == AllocatorType.POOL or \
+                 -(-oldSize // self.alignment) * self.alignment <= SIZE_CLASS_MAX_SIZE:
+                self.live.append((ptr, oldSize))
+
+    """
+    Freed pool slots and size class slots are handed out again before any
+    new slot of their size, most recently freed first. They come back
+    zero-filled, except for pool slots of arenas that do not zero on reset.
+    Large size class allocations are only reclaimed by a reset, so the
+    memory handed out instead is only zero if reset zeroes it, and may not
+    be available at all once the arena reached its capacity limit.
+    """
+    @rule(data=integers(0, 255))
+    @precondition(lambda self: self.arena and self.live)
+    def free(self, data):
+        ptr, allocSize = self.live.pop()
+        ctypes.memset(ptr, data, allocSize)
+        lib.memory_arena_free(ctypes.pointer(self.arena), ptr)
+
+        reused = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        if self.allocator_type == AllocatorType.POOL or \
+           -(-allocSize // self.alignment) * self.alignment <= SIZE_CLASS_MAX_SIZE:
+            assert reused == ptr
+            if self.allocator_type != AllocatorType.POOL or self.zeroing != MemoryResetZeroing.NONE:
+                assert ctypes.string_at(reused, allocSize) == bytes(allocSize)
+        elif not reused:
+            assert self.limit
+            return
+        elif self.zeroing != MemoryResetZeroing.NONE:
+            assert ctypes.string_at(reused, allocSize) == bytes(allocSize)
+        self.live.append((reused, allocSize))
+
+    """
+    Every live size class allocation is accounted for in exactly one class,
+    and no class has more live slots than it has slots.
+    """
+    @rule()
+    @precondition(lambda self: self.arena and self.allocator_type == AllocatorType.SIZE_CLASS)
+    def size_class_occupancy(self):
+        occupancy = (MemorySizeClassOccupancy * MEMORY_SIZE_CLASS_COUNT)()
+        written = lib.memory_arena_size_class_occupancy(self.arena, occupancy, MEMORY_SIZE_CLASS_COUNT)
+        assert written == MEMORY_SIZE_CLASS_COUNT
+
+        small = [size for _, size in self.live
+                 if -(-size // self.alignment) * self.alignment <= SIZE_CLASS_MAX_SIZE]
+        assert sum(entry.live for entry in occupancy) == len(small)
+        for entry in occupancy:
+            assert entry.live <= entry.slots
+
+    """
+    A successful allocation is counted once with its requested size, the
+    blocks of the arena hold every byte it used, and the arena is part of
+    the process-wide statistics.
+    """
+    @rule(allocSize=integers(1, (1 << 10)))
+    @precondition(lambda self: self.arena)
+    def stats(self, allocSize):
+        before = MemoryArenaStats()
+        lib.memory_arena_get_stats(self.arena, ctypes.byref(before))
+        ptr = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        after = MemoryArenaStats()
+        lib.memory_arena_get_stats(self.arena, ctypes.byref(after))
+
+        if ptr:
+            assert after.allocations == before.allocations + 1
+            assert after.bytes_requested == before.bytes_requested + allocSize
+            if self.allocator_type in FREEABLE_TYPES:
+                self.live.append((ptr, allocSize))
+        else:
+            assert after.allocations == before.allocations
+        assert after.blocks >= 1
+        assert after.bytes_used <= after.capacity
+        assert after.high_water >= after.bytes_used
+        assert after.block_maps + after.block_reuses == after.blocks + after.block_releases
+        assert after.block_unmaps <= after.block_releases
+
+        total = MemoryGlobalStats()
+        lib.memory_arena_get_global_stats(ctypes.byref(total))
+        assert total.arenas >= 1
+        assert total.allocations >= after.allocations
+        assert total.mmap_calls >= total.block_maps
+        assert total.munmap_calls >= total.block_unmaps
+
+    """
+    Virtual arenas hand out consecutive allocations back to back, committing
+    memory well past their initial capacity, until the reservation runs out.
+    """
+    @rule(allocSize=integers(1, (1 << 22)), data=integers(0, 255))
+    @precondition(lambda self: self.arena and self.allocator_type == AllocatorType.VIRTUAL)
+    def virtual_contiguous(self, allocSize, data):
+        first = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        second = lib.memory_arena_alloc(ctypes.pointer(self.arena), allocSize)
+        if first and second:
+            assert second == first + -(-allocSize // self.alignment) * self.alignment
+            ctypes.memset(first, data, 2 * allocSize)
+        if not first:
+            assert not second
+            assert not lib.memory_arena_alloc_verify(self.arena, allocSize)
 
     """
     Allocation verifier should be able to predict if a memory arena allocation will fail or 
@@ -126,6 +636,46 @@ class MemoryArenaModel(RuleBasedStateMachine):
         else:
             assert not arena_ptr
 
+        if arena_ptr and self.allocator_type in FREEABLE_TYPES:
+            self.live.append((arena_ptr, allocSize))
+
+
+    """
+    The thread arena is created on first use, always available and survives
+    its own resets until it is released.
+    """
+    @rule(allocSize=integers(1,(1<<10)), release=sampled_from([False, True]))
+    def thread_arena_alloc(self, allocSize, release):
+        thread_arena = lib.memory_thread_arena()
+        assert thread_arena
+        assert lib.memory_arena_alloc(ctypes.pointer(thread_arena), allocSize)
+
+        if release:
+            lib.memory_thread_arena_release()
+        else:
+            lib.memory_arena_reset(ctypes.pointer(thread_arena))
+
+    """
+    A thread arena created for a node is the thread's arena until it is
+    released, and its memory is bound to that node.
+    """
+    @rule(allocSize=integers(1,(1<<10)))
+    def thread_arena_on_node(self, allocSize):
+        lib.memory_thread_arena_release()
+        node = lib.memory_numa_node()
+        thread_arena = lib.memory_thread_arena_on_node(node)
+        assert thread_arena
+        assert ctypes.addressof(lib.memory_thread_arena().contents) == ctypes.addressof(thread_arena.contents)
+        assert ctypes.addressof(lib.memory_thread_arena_on_node(node).contents) == \
+               ctypes.addressof(thread_arena.contents)
+
+        ptr = lib.memory_arena_alloc(ctypes.pointer(thread_arena), allocSize)
+        assert ptr
+        mode = ctypes.c_int()
+        nodes = (ctypes.c_ulong * 2)()
+        if libc.syscall(SYS_get_mempolicy, ctypes.byref(mode), nodes, 128, ctypes.c_void_p(ptr), MPOL_F_ADDR) == 0:
+            assert mode.value == MPOL_BIND
+        lib.memory_thread_arena_release()
 
     """
     Ensure the arena is and all allocated memory is destroyed at the end of the test.
@@ -134,5 +684,662 @@ class MemoryArenaModel(RuleBasedStateMachine):
         if (self.arena):
             lib.memory_arena_destroy(ctypes.pointer(self.arena))
             self.arena = ctypes.POINTER(MemoryArena)()
+        lib.memory_thread_arena_release()
 
 TestMyStateMachine = MemoryArenaModel.TestCase
+
+
+"""
+Arenas with a capacity limit stop growing before their blocks exceed it,
+so allocating fails instead, and the allocation verifier agrees. Blocks
+rounded up to huge pages and the reservation of VIRTUAL arenas count
+against the limit as well.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.STACK, AllocatorType.POOL,
+                                AllocatorType.CONCURRENT, AllocatorType.SIZE_CLASS, AllocatorType.VIRTUAL]),
+    capacity=integers(min_value=1, max_value=(1 << 14)),
+    limit=integers(min_value=(1 << 17), max_value=(1 << 19)),
+    allocSize=integers(1, (1 << 12)),
+    hugePages=sampled_from([False, True])
+)
+def test_capacity_limit(allocatorType, capacity, limit, allocSize, hugePages):
+    # Huge page blocks fill at least 2 MiB, keep room for a few of them
+    if hugePages:
+        limit += 2 * (1 << 21)
+        allocSize *= 64
+    options = MemoryArenaOptions(capacity_limit=limit, pool_slot_size=allocSize, huge_pages=hugePages)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    for _ in range(limit // allocSize + 2):
+        canAlloc = lib.memory_arena_alloc_verify(arena, allocSize)
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        if canAlloc:
+            assert ptr
+        if not ptr:
+            break
+    assert not ptr
+
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.capacity <= limit
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Large allocations in LINEAR and POOL arenas are mapped on their own,
+one block each, and reset releases them without growing the chain.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.POOL]),
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    allocSize=integers((1 << 13), (1 << 22)),
+    data=integers(1, 255)
+)
+def test_large_allocation(allocatorType, capacity, allocSize, data):
+    options = MemoryArenaOptions(large_threshold=(1 << 12), pool_slot_size=allocSize)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+    assert ptr
+    ctypes.memset(ptr, data, allocSize)
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.blocks == 2
+    assert stats.bytes_used >= allocSize
+
+    small = lib.memory_arena_alloc(ctypes.pointer(arena), 1)
+    assert small
+    assert not ptr <= small < ptr + allocSize
+
+    lib.memory_arena_reset(ctypes.pointer(arena))
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.block_releases >= 1
+    assert stats.capacity < allocSize
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Every block of an arena with a NUMA policy reports that policy to
+get_mempolicy, bound to the requested node or interleaved. Kernels
+without NUMA support place the blocks as usual.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from(AllocatorType),
+    numaPolicy=sampled_from([MemoryNumaPolicy.BIND, MemoryNumaPolicy.INTERLEAVE]),
+    allocSize=integers(1, (1 << 16))
+)
+def test_numa_placement(allocatorType, numaPolicy, allocSize):
+    node = lib.memory_numa_node()
+    options = MemoryArenaOptions(numa_policy=numaPolicy, numa_node=node, pool_slot_size=allocSize)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, 4096, ctypes.byref(options))
+    assert arena
+
+    for _ in range(4):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        if not ptr:
+            break
+        mode = ctypes.c_int()
+        nodes = (ctypes.c_ulong * 2)()
+        if libc.syscall(SYS_get_mempolicy, ctypes.byref(mode), nodes, 128, ctypes.c_void_p(ptr),
+                        MPOL_F_ADDR) != 0:
+            break
+        if numaPolicy == MemoryNumaPolicy.BIND:
+            assert mode.value == MPOL_BIND
+            assert nodes[node // 64] == 1 << (node % 64)
+        else:
+            assert mode.value == MPOL_INTERLEAVE
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Blocks an arena with a NUMA policy released to the block recycler lose
+that policy when an arena without one takes them over, so its memory is
+placed as if it had been freshly mapped.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.STACK, AllocatorType.POOL,
+                                AllocatorType.CONCURRENT]),
+    numaPolicy=sampled_from([MemoryNumaPolicy.BIND, MemoryNumaPolicy.INTERLEAVE]),
+    capacity=integers(min_value=(1 << 12), max_value=(1 << 16))
+)
+def test_numa_default_after_bind(allocatorType, numaPolicy, capacity):
+    def grow(options):
+        arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+        assert arena
+        ptrs = [lib.memory_arena_alloc(ctypes.pointer(arena), capacity) for _ in range(4)]
+        assert all(ptrs)
+        return arena, ptrs
+
+    lib.memory_recycler_drain()
+    placed = MemoryArenaOptions(numa_policy=numaPolicy, numa_node=lib.memory_numa_node(), pool_slot_size=capacity)
+    arena, _ = grow(placed)
+    lib.memory_arena_destroy(arena)
+
+    arena, ptrs = grow(MemoryArenaOptions(pool_slot_size=capacity))
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.block_reuses >= 1
+    for ptr in ptrs:
+        mode = ctypes.c_int()
+        nodes = (ctypes.c_ulong * 2)()
+        if libc.syscall(SYS_get_mempolicy, ctypes.byref(mode), nodes, 128, ctypes.c_void_p(ptr),
+                        MPOL_F_ADDR) != 0:
+            break
+        assert mode.value == MPOL_DEFAULT
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Prefaulted arenas hand out memory that is resident before it is first
+touched, and still zero-filled.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.SCRATCH, AllocatorType.LINEAR, AllocatorType.STACK,
+                                AllocatorType.POOL, AllocatorType.CONCURRENT, AllocatorType.SIZE_CLASS]),
+    capacity=integers(min_value=1, max_value=(1 << 16)),
+    allocSize=integers(1, (1 << 12))
+)
+def test_prefault_blocks(allocatorType, capacity, allocSize):
+    options = MemoryArenaOptions(prefault=True, pool_slot_size=allocSize)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    for _ in range(4):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        if not ptr:
+            break
+        assert page_resident(ptr)
+        assert page_resident(ptr + allocSize - 1)
+        assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Growing arenas with a spare block keep handing out distinct, zero-filled
+memory across several blocks, whether the spare was ready or not, and
+survive reset and destroy while the refill thread may be preparing one.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.STACK, AllocatorType.POOL,
+                                AllocatorType.CONCURRENT, AllocatorType.SIZE_CLASS]),
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    allocSize=integers(1, (1 << 12)),
+    count=integers(1, 64),
+    data=integers(1, 255)
+)
+def test_spare_block(allocatorType, capacity, allocSize, count, data):
+    options = MemoryArenaOptions(spare_block=True, pool_slot_size=allocSize)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    ptrs = []
+    for _ in range(count):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        assert ptr
+        assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+        ctypes.memset(ptr, data, allocSize)
+        ptrs.append(ptr)
+    ptrs.sort()
+    for first, second in zip(ptrs, ptrs[1:]):
+        assert first + allocSize <= second
+
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.blocks == stats.block_maps + stats.block_reuses - stats.block_releases
+    lib.memory_arena_reset(ctypes.pointer(arena))
+    assert lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+    lib.memory_arena_destroy(arena)
+
+
+"""
+A stack that records, allocates across a block boundary and unwinds in a
+loop keeps the blocks it grew into cached, so only the first iteration
+obtains blocks. Reused blocks come back zeroed, and a cache that goes
+unused for STACK_CACHE_DECAY unwinds in a row is released.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    allocSize=integers(1, (1 << 14)),
+    depth=integers(1, 2),
+    data=integers(1, 255)
+)
+def test_stack_block_cache(capacity, allocSize, depth, data):
+    arena = lib.memory_arena_create(AllocatorType.STACK, 16, capacity)
+    assert arena
+    assert lib.memory_arena_alloc(ctypes.pointer(arena), capacity)
+
+    stats = MemoryArenaStats()
+    obtained = None
+    for _ in range(8):
+        lib.memory_stack_arena_record(ctypes.pointer(arena))
+        for _ in range(depth):
+            ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+            assert ptr
+            assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+            ctypes.memset(ptr, data, allocSize)
+        lib.memory_stack_arena_unwind(ctypes.pointer(arena))
+        lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+        if obtained is None:
+            obtained = stats.block_maps + stats.block_reuses
+        assert stats.block_maps + stats.block_reuses == obtained
+    assert stats.blocks > 1
+
+    for _ in range(16):
+        lib.memory_stack_arena_record(ctypes.pointer(arena))
+        lib.memory_stack_arena_unwind(ctypes.pointer(arena))
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.blocks == 1
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Restoring a stack arena to any of several nested marks releases every
+allocation made after it in one call, keeps the ones made before it
+intact and hands the released space out again. Growing an allocation made
+before a mark copies it rather than growing it across the mark.
+"""
+@hypothesis.settings(max_examples=100, deadline=None)
+@given(
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    sizes=lists(integers(1, (1 << 12)), min_size=1, max_size=16),
+    depth=integers(0, 15),
+    grow=integers(0, (1 << 8))
+)
+def test_stack_marks(capacity, sizes, depth, grow):
+    arena = lib.memory_arena_create(AllocatorType.STACK, 16, capacity)
+    assert arena
+
+    marks = []
+    ptrs = []
+    stats = MemoryArenaStats()
+    for i, size in enumerate(sizes):
+        lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+        marks.append((lib.memory_stack_arena_mark(arena), stats.bytes_requested))
+        if i % 2:
+            lib.memory_stack_arena_record(ctypes.pointer(arena))
+        if grow and ptrs:
+            last, lastSize = ptrs[-1]
+            grown = lib.memory_arena_realloc(ctypes.pointer(arena), last, lastSize, lastSize + grow)
+            assert grown and grown != last
+            ctypes.memset(grown, 255, lastSize + grow)
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), size)
+        assert ptr
+        ctypes.memset(ptr, i + 1, size)
+        ptrs.append((ptr, size))
+
+    depth %= len(marks)
+    mark, requested = marks[depth]
+    lib.memory_stack_arena_restore(ctypes.pointer(arena), mark)
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.bytes_requested == requested
+    for i, (ptr, size) in enumerate(ptrs[:depth]):
+        assert ctypes.string_at(ptr, size) == bytes([i + 1]) * size
+
+    # Snapshots recorded before the mark survive the restore, the last one before allocation
+    # `kept` was recorded
+    kept = depth
+    if depth // 2:
+        lib.memory_stack_arena_unwind(ctypes.pointer(arena))
+        kept = depth - 1 if depth % 2 == 0 else depth - 2
+    ptr = lib.memory_arena_alloc(ctypes.pointer(arena), sizes[depth])
+    assert ptr
+    ctypes.memset(ptr, 255, sizes[depth])
+    for i, (ptr, size) in enumerate(ptrs[:kept]):
+        assert ctypes.string_at(ptr, size) == bytes([i + 1]) * size
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Rolling a bump allocated arena back to nested checkpoints releases the
+allocations made after each, including ones that grew the chain or got
+large blocks, keeps the earlier ones intact and hands out zeroed memory.
+Best-fit arenas warmed up and reset with retained blocks never place an
+allocation where a later rollback would release it, stack arenas drop the
+snapshots recorded since the checkpoint, and resizing the allocation made
+just before a checkpoint never moves the checkpoint.
+"""
+@hypothesis.settings(max_examples=200, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.SCRATCH, AllocatorType.LINEAR, AllocatorType.STACK,
+                                AllocatorType.CONCURRENT, AllocatorType.VIRTUAL]),
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    sizes=lists(integers(1, (1 << 13)), min_size=3, max_size=24),
+    largeThreshold=sampled_from([0, (1 << 12)]),
+    bestFit=sampled_from([False, True]),
+    retainBlocks=sampled_from([0, 2, SIZE_MAX]),
+    warmUp=sampled_from([False, True]),
+    resize=integers(-(1 << 8), (1 << 8))
+)
+def test_checkpoint_rollback(allocatorType, capacity, sizes, largeThreshold, bestFit, retainBlocks, warmUp,
+                             resize):
+    options = MemoryArenaOptions(large_threshold=largeThreshold, best_fit=bestFit, retain_blocks=retainBlocks)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    if warmUp:
+        for size in reversed(sizes):
+            lib.memory_arena_alloc(ctypes.pointer(arena), size)
+        lib.memory_arena_reset(ctypes.pointer(arena))
+
+    third = len(sizes) // 3
+    checkpoints = []
+    live = []
+    stats = MemoryArenaStats()
+    for i, size in enumerate(sizes):
+        if i in (third, 2 * third):
+            lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+            checkpoint = lib.memory_arena_checkpoint(arena)
+            used = stats.bytes_used
+            # A copy made by growing the last allocation is released by the rollback, only a
+            # large allocation in a block of its own is resized in place and stays resized
+            if resize and live:
+                last, lastSize, data = live[-1]
+                newSize = max(1, lastSize + resize)
+                resized = lib.memory_arena_realloc(ctypes.pointer(arena), last, lastSize, newSize)
+                if resized == last:
+                    live[-1] = (last, min(lastSize, newSize), data)
+                    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+                    used = stats.bytes_used
+                elif resized:
+                    ctypes.memset(resized, 255, newSize)
+            checkpoints.append((checkpoint, len(live), used))
+        if allocatorType == AllocatorType.STACK and i % 3 == 1:
+            lib.memory_stack_arena_record(ctypes.pointer(arena))
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), size)
+        if ptr:
+            ctypes.memset(ptr, i % 255 + 1, size)
+            live.append((ptr, size, i % 255 + 1))
+
+    for checkpoint, count, used in reversed(checkpoints):
+        lib.memory_arena_rollback(ctypes.pointer(arena), checkpoint)
+        lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+        if not bestFit:
+            assert stats.bytes_used == used
+        del live[count:]
+        for ptr, size, data in live:
+            assert ctypes.string_at(ptr, size) == bytes([data]) * size
+        if allocatorType == AllocatorType.STACK:
+            assert lib.memory_stack_arena_mark(arena).snapshots == checkpoint.snapshots
+
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), sizes[-1])
+        if ptr:
+            assert ctypes.string_at(ptr, sizes[-1]) == bytes(sizes[-1])
+            ctypes.memset(ptr, 255, sizes[-1])
+            for ptr, size, data in live:
+                assert ctypes.string_at(ptr, size) == bytes([data]) * size
+        lib.memory_arena_rollback(ctypes.pointer(arena), checkpoint)
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Threads sharing a CONCURRENT arena get aligned, non-overlapping memory,
+including across the blocks the arena grows into while they race, and
+every allocation is counted exactly once.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    capacity=integers(min_value=1, max_value=(1 << 12)),
+    sizes=lists(integers(1, (1 << 10)), min_size=1, max_size=256),
+    threads=integers(2, 8)
+)
+def test_concurrent_threads(capacity, sizes, threads):
+    arena = lib.memory_arena_create(AllocatorType.CONCURRENT, 16, capacity)
+    assert arena
+
+    start = threading.Barrier(threads)
+    claimed = [[] for _ in range(threads)]
+
+    def worker(index):
+        start.wait()
+        for size in sizes:
+            ptr = lib.memory_arena_alloc(ctypes.pointer(arena), size)
+            assert ptr
+            ctypes.memset(ptr, index + 1, size)
+            claimed[index].append((ptr, size))
+
+    workers = [threading.Thread(target=worker, args=(index,)) for index in range(threads)]
+    for thread in workers:
+        thread.start()
+    for thread in workers:
+        thread.join()
+
+    assert all(len(spans) == len(sizes) for spans in claimed)
+    spans = sorted((ptr, size) for owned in claimed for ptr, size in owned)
+    assert all(ptr % 16 == 0 for ptr, _ in spans)
+    for (ptr, size), (next_ptr, _) in zip(spans, spans[1:]):
+        assert ptr + size <= next_ptr
+    for index, owned in enumerate(claimed):
+        for ptr, size in owned:
+            assert ctypes.string_at(ptr, size) == bytes([index + 1]) * size
+
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.allocations == threads * len(sizes)
+    assert stats.bytes_requested == threads * sum(sizes)
+    assert stats.block_maps + stats.block_reuses == stats.blocks + stats.block_releases
+    lib.memory_arena_destroy(arena)
+
+
+"""
+Blocks released by an arena on one thread are picked up by an arena grown
+on another thread, zero-filled, and threads creating, growing and
+destroying arenas at the same time never hand out a block twice.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.STACK, AllocatorType.CONCURRENT]),
+    capacity=integers(min_value=(1 << 12), max_value=(1 << 16)),
+    threads=integers(2, 4),
+    data=integers(1, 255)
+)
+def test_recycler_threads(allocatorType, capacity, threads, data):
+    # Allocations of a whole head block grow the arena by several blocks
+    allocSize = capacity
+
+    def grow(stats, fill):
+        arena = lib.memory_arena_create(allocatorType, 16, capacity)
+        assert arena
+        for _ in range(8):
+            ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+            assert ptr
+            assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+            ctypes.memset(ptr, fill, allocSize)
+        lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+        lib.memory_arena_destroy(arena)
+
+    lib.memory_recycler_drain()
+    released = MemoryArenaStats()
+    acquired = MemoryArenaStats()
+    releaser = threading.Thread(target=grow, args=(released, data))
+    releaser.start()
+    releaser.join()
+    acquirer = threading.Thread(target=grow, args=(acquired, data))
+    acquirer.start()
+    acquirer.join()
+    assert released.blocks > 1
+    assert acquired.block_reuses >= 1
+
+    results = [MemoryArenaStats() for _ in range(threads)]
+    workers = [threading.Thread(target=lambda stats=stats, fill=fill: [grow(stats, fill) for _ in range(4)])
+               for fill, stats in enumerate(results, start=1)]
+    for thread in workers:
+        thread.start()
+    for thread in workers:
+        thread.join()
+    assert all(stats.blocks > 1 for stats in results)
+
+
+"""
+A recycled block is only handed to an arena needing more than half of the
+capacity it was mapped with, however many smaller arenas took it before.
+"""
+@hypothesis.settings(max_examples=50, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.SCRATCH, AllocatorType.LINEAR]),
+    capacity=integers(min_value=(1 << 16), max_value=(1 << 24)),
+    shrink=integers(55, 95)
+)
+def test_recycler_waste_bound(allocatorType, capacity, shrink):
+    lib.memory_recycler_drain()
+    arena = lib.memory_arena_create(allocatorType, 16, capacity)
+    assert arena
+    original = lib.memory_arena_alloc(ctypes.pointer(arena), 1)
+    assert original
+    lib.memory_arena_destroy(arena)
+
+    size = capacity
+    while size > (1 << 12):
+        size = size * shrink // 100
+        arena = lib.memory_arena_create(allocatorType, 16, size)
+        assert arena
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), 1)
+        assert ptr
+        if size * 2 <= capacity:
+            assert ptr != original
+        lib.memory_arena_destroy(arena)
+
+
+"""
+Blocks too large for the block recycler are unmapped when an arena releases
+them, and the arena counts each of them as well as the process does.
+"""
+@hypothesis.settings(max_examples=20, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.LINEAR, AllocatorType.STACK, AllocatorType.CONCURRENT]),
+    capacity=integers(min_value=(1 << 12), max_value=(1 << 16)),
+    allocSize=integers(min_value=(1 << 26) + 1, max_value=(1 << 26) + (1 << 20)),
+    resets=integers(1, 3)
+)
+def test_block_unmaps(allocatorType, capacity, allocSize, resets):
+    options = MemoryArenaOptions(reset_zeroing=MemoryResetZeroing.NONE)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+
+    before = MemoryGlobalStats()
+    lib.memory_arena_get_global_stats(ctypes.byref(before))
+    for _ in range(resets):
+        assert lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        lib.memory_arena_reset(ctypes.pointer(arena))
+    after = MemoryGlobalStats()
+    lib.memory_arena_get_global_stats(ctypes.byref(after))
+
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(arena, ctypes.byref(stats))
+    assert stats.block_unmaps == resets
+    assert stats.block_releases >= stats.block_unmaps
+    assert after.munmap_calls - before.munmap_calls >= resets
+    lib.memory_arena_destroy(arena)
+
+"""
+Memory an arena without reset zeroing rewound past, by a reset, a stack
+unwind or a rollback, is cleared before its blocks are recycled, so a
+fresh arena taking them over still hands out zero-filled memory.
+"""
+@hypothesis.settings(max_examples=100, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.SCRATCH, AllocatorType.LINEAR, AllocatorType.STACK,
+                                AllocatorType.POOL, AllocatorType.CONCURRENT, AllocatorType.SIZE_CLASS]),
+    capacity=integers(min_value=(1 << 12), max_value=(1 << 16)),
+    allocSize=integers(1, (1 << 10)),
+    rewind=sampled_from(["reset", "unwind", "rollback"]),
+    data=integers(1, 255)
+)
+def test_unzeroed_blocks_recycled_clean(allocatorType, capacity, allocSize, rewind, data):
+    assume(rewind != "unwind" or allocatorType == AllocatorType.STACK)
+    assume(rewind != "rollback" or allocatorType in (AllocatorType.SCRATCH, AllocatorType.LINEAR,
+                                                     AllocatorType.STACK, AllocatorType.CONCURRENT))
+    count = capacity // allocSize
+
+    lib.memory_recycler_drain()
+    options = MemoryArenaOptions(reset_zeroing=MemoryResetZeroing.NONE, pool_slot_size=allocSize)
+    arena = lib.memory_arena_create_with_options(allocatorType, 16, capacity, ctypes.byref(options))
+    assert arena
+    if rewind == "unwind":
+        lib.memory_stack_arena_record(ctypes.pointer(arena))
+    checkpoint = lib.memory_arena_checkpoint(arena) if rewind == "rollback" else None
+    for _ in range(count):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(arena), allocSize)
+        if not ptr:
+            break
+        ctypes.memset(ptr, data, allocSize)
+
+    if rewind == "reset":
+        lib.memory_arena_reset(ctypes.pointer(arena))
+    elif rewind == "unwind":
+        lib.memory_stack_arena_unwind(ctypes.pointer(arena))
+    else:
+        lib.memory_arena_rollback(ctypes.pointer(arena), checkpoint)
+    lib.memory_arena_destroy(arena)
+
+    fresh = lib.memory_arena_create_with_options(allocatorType, 16, capacity,
+                                                 ctypes.byref(MemoryArenaOptions(pool_slot_size=allocSize)))
+    assert fresh
+    stats = MemoryArenaStats()
+    lib.memory_arena_get_stats(fresh, ctypes.byref(stats))
+    assert stats.block_reuses >= 1
+    for _ in range(count):
+        ptr = lib.memory_arena_alloc(ctypes.pointer(fresh), allocSize)
+        if not ptr:
+            break
+        assert ctypes.string_at(ptr, allocSize) == bytes(allocSize)
+    lib.memory_arena_destroy(fresh)
+
+
+"""
+The inline fast path and memory_arena_alloc agree allocation for allocation:
+both succeed or fail together, hand out aligned, zero-filled memory at the
+same position of identical arenas, and count it the same way, across block
+growth, committing and resets.
+"""
+@hypothesis.settings(max_examples=200, deadline=None)
+@given(
+    allocatorType=sampled_from([AllocatorType.SCRATCH, AllocatorType.LINEAR, AllocatorType.STACK,
+                                AllocatorType.VIRTUAL]),
+    exponent=sampled_from([3, 4, 6]),
+    capacity=integers(min_value=1, max_value=(1 << 14)),
+    sizes=lists(integers(0, (1 << 12)), min_size=1, max_size=64),
+    data=integers(1, 255)
+)
+def test_inline_alloc_matches(allocatorType, exponent, capacity, sizes, data):
+    alignment = 1 << exponent
+    inline = lib.memory_arena_create(allocatorType, alignment, capacity)
+    outline = lib.memory_arena_create(allocatorType, alignment, capacity)
+    assert inline and outline
+
+    inlineStats = MemoryArenaStats()
+    outlineStats = MemoryArenaStats()
+    for size in sizes:
+        # A zero size resets both arenas instead
+        if size == 0:
+            lib.memory_arena_reset(ctypes.pointer(inline))
+            lib.memory_arena_reset(ctypes.pointer(outline))
+            continue
+
+        fast = probe.arena_inline_probe_alloc(ctypes.pointer(inline), allocatorType, alignment, size)
+        slow = lib.memory_arena_alloc(ctypes.pointer(outline), size)
+        assert bool(fast) == bool(slow)
+        if fast:
+            assert fast % alignment == 0
+            assert ctypes.string_at(fast, size) == bytes(size)
+            ctypes.memset(fast, data, size)
+            ctypes.memset(slow, data, size)
+
+        assert lib.memory_arena_checkpoint(inline).position == lib.memory_arena_checkpoint(outline).position
+        lib.memory_arena_get_stats(inline, ctypes.byref(inlineStats))
+        lib.memory_arena_get_stats(outline, ctypes.byref(outlineStats))
+        assert inlineStats.allocations == outlineStats.allocations
+        assert inlineStats.bytes_requested == outlineStats.bytes_requested
+        assert inlineStats.bytes_used == outlineStats.bytes_used
+        assert inlineStats.blocks == outlineStats.blocks
+    lib.memory_arena_destroy(inline)
+    lib.memory_arena_destroy(outline)